@@ -1,18 +1,26 @@
+#include <math.h>
 #include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 #include <jack/jack.h>
 
 #include "clis.h"
+#include "clis_render.h"
+#include "clis_stats.h"
 
 #define DEFAULT_PORT   "output"
 
 int is_running = 0;
 
+// the clients own process callback, wrapped so renders can capture its output
+static JackProcessCallback  client_process_cb;
+static void                 *client_process_cb_arg;
+
 
 void
-clis_run()
+clis_run(void)
 {
     is_running = 1;
     while(is_running) {
@@ -36,6 +44,22 @@ jack_shutdown (void *arg)
     is_running = 0;
 }
 
+static int
+process(jack_nframes_t nframes, void *arg)
+{
+    int rc;
+
+    (void)arg;
+
+    clis_stats_begin();
+    rc = client_process_cb(nframes, client_process_cb_arg);
+    clis_stats_end(nframes);
+
+    clis_render_process(nframes);
+
+    return rc;
+}
+
 clis_rc 
 clis_init_client(char *client_name, char *server_name, jack_client_t **client,
         JackProcessCallback process_cb, void *process_cb_arg,
@@ -64,8 +88,16 @@ clis_init_client(char *client_name, char *server_name, jack_client_t **client,
     // signals server exited
     jack_on_shutdown(*client, jack_shutdown, 0);
 
+    client_process_cb       = process_cb;
+    client_process_cb_arg   = process_cb_arg;
+
     if(process_cb != NULL &&
-        jack_set_process_callback(*client, process_cb, process_cb_arg) != 0) {
+        jack_set_process_callback(*client, process, NULL) != 0) {
+        return CLIS_E_JACK_CALLBACK;
+    }
+
+    // the process callback is always timed, clis_stats_start reports it
+    if(clis_stats_init(*client) != CLIS_OK) {
         return CLIS_E_JACK_CALLBACK;
     }
 
@@ -83,39 +115,188 @@ clis_init_client(char *client_name, char *server_name, jack_client_t **client,
     return CLIS_OK;
 }
 
+/**
+ *  Build the routing table of a parameter from its mod sources. Only called
+ *  before the client is activated, the process thread never sees it change.
+ *
+ *  @param param - the parameter to route
+ */
 static void
-port_registered(jack_port_id_t port_id, int is_registering, void *arg)
+build_routes(parameter *param)
 {
-    clis_context *context       = (clis_context *)arg;
-    jack_port_t *port           = jack_port_by_id(context->client, port_id);
+    mod_routes *next = &param->routes;
+    size_t i, length = 0;
 
-    if(jack_port_is_mine(context->client, port)) {
-        return;
+    for(i = 0; i < param->mods.length; i++) {
+        mod_source *source = &param->mods.sources[i];
+
+        if(source->input == NULL && source->local == NULL)
+            continue;
+
+        next->routes[length].port   = source->input;
+        next->routes[length].local  = source->local;
+        next->routes[length].gain   = source->value * param->mod_scale;
+        length++;
+    }
+    next->length = length;
+}
+
+/**
+ *  Point every mod source subscribed to an index entry at port and have the
+ *  connector thread connect a new port to their inputs. JACK drops the
+ *  connections of a port that goes by itself. The caller must hold the
+ *  contexts routes_lock.
+ *
+ *  @param context - the context owning the parameters
+ *  @param entry - the index entry whose port came or went
+ *  @param port - the new port or NULL if it was unregistered
+ */
+static void
+update_subscribers(clis_context *context, clis_index_entry *entry,
+                   jack_port_t *port)
+{
+    size_t i;
+    parameter *param;
+
+    for(i = 0; i < entry->subscribers_length; i++) {
+        param = &context->params[entry->subscribers[i].param];
+        param->mods.sources[entry->subscribers[i].source].port = port;
+    }
+
+    entry->connect = port != NULL;
+    if(entry->connect) {
+        context->connect_pending = true;
+        pthread_cond_signal(&context->connect_cond);
+    }
+}
+
+/**
+ *  Connect the ports of the index entries flagged by update_subscribers to
+ *  the inputs of their subscribers. The caller must hold the contexts
+ *  routes_lock, it is dropped around each jack_connect as the server may be
+ *  waiting on the notification thread, which takes the lock.
+ */
+static void
+connect_sources(clis_context *context)
+{
+    clis_index_entry *entry;
+    clis_subscriber *subscriber;
+    mod_source *source;
+    size_t i, j;
+
+    for(i = 0; i < context->index.length; i++) {
+        entry = &context->index.entries[i];
+        if(!entry->connect)
+            continue;
+        entry->connect = 0;
+
+        // the entries and their subscribers never change after clis_start
+        pthread_mutex_unlock(&context->routes_lock);
+        for(j = 0; j < entry->subscribers_length; j++) {
+            subscriber  = &entry->subscribers[j];
+            source      = &context->params[subscriber->param]
+                .mods.sources[subscriber->source];
+            jack_connect(context->client, entry->name,
+                    jack_port_name(source->input));
+        }
+        pthread_mutex_lock(&context->routes_lock);
     }
+}
 
-    const char *port_name       = jack_port_name(port);
-    const char *client_name     = jack_get_client_name(context->client);
-    unsigned int i, j;
+static void *
+connector_main(void *arg)
+{
+    clis_context *context = (clis_context *)arg;
 
-    printf("%s %s on %s\n", port_name, 
-            is_registering ? "registered" : "unregistered", 
-            client_name);
+    pthread_mutex_lock(&context->routes_lock);
+    while(!context->connector_quit) {
+        if(!context->connect_pending) {
+            pthread_cond_wait(&context->connect_cond, &context->routes_lock);
+            continue;
+        }
+        context->connect_pending = false;
+        connect_sources(context);
+    }
+    pthread_mutex_unlock(&context->routes_lock);
+
+    return NULL;
+}
+
+/**
+ *  Register an input port for every mod source that is not rendered in this
+ *  process. JACK connects the source to it and so orders this client after
+ *  the source, and hands the process thread the sources buffer through it
+ *  without a copy when it is the only connection.
+ *
+ *  @param context - the context owning the parameters
+ *  @return CLIS_OK or CLIS_E_REGISTER_PORT
+ */
+static clis_rc
+register_inputs(clis_context *context)
+{
+    char name[256];
+    mod_source *source;
+    size_t i, j;
 
     for(i = 0; i < context->params_length; i++) {
+        for(j = 0; j < context->params[i].mods.length; j++) {
+            source = &context->params[i].mods.sources[j];
+            if(source->local != NULL)
+                continue;
 
-        parameter param = context->params[i];
-        printf("%s has %d mods configured\n", client_name, param.mods.length);
-        for(j = 0; j < param.mods.length; j++) {
+            if(context->names != NULL)
+                snprintf(name, sizeof name, "%s.mod%zu", context->names[i], j);
+            else
+                snprintf(name, sizeof name, "param%zu.mod%zu", i, j);
 
-            if(strcmp(param.mods.sources[j].name, port_name) == 0) {
+            source->input = jack_port_register(context->client, name,
+                    JACK_DEFAULT_AUDIO_TYPE, JackPortIsInput, 0);
+            if(source->input == NULL)
+                return CLIS_E_REGISTER_PORT;
+        }
+    }
 
-                param.mods.sources[j].port = is_registering ? port : NULL;
-                printf("CALLBACK added mod source %s to %s on port %p\n", 
-                        param.mods.sources[j].name, client_name, port);
-            }
+    return CLIS_OK;
+}
+
+/**
+ *  JACK port registration callback. Runs on the JACK notification thread for
+ *  every port of every client, ports nothing subscribes to miss the index and
+ *  cost a hash lookup.
+ */
+static void
+port_registered(jack_port_id_t port_id, int is_registering, void *arg)
+{
+    clis_context *context       = (clis_context *)arg;
+    clis_index_entry *entry     = NULL;
+    jack_port_t *port           = jack_port_by_id(context->client, port_id);
+
+    if(port == NULL || jack_port_is_mine(context->client, port)) {
+        return;
+    }
+
+    pthread_mutex_lock(&context->routes_lock);
+
+    if(is_registering) {
+        entry = clis_index_find_name(&context->index, jack_port_name(port));
+        if(entry != NULL) {
+            clis_index_bind(&context->index, entry, port_id);
+            update_subscribers(context, entry, port);
+        }
+    } else {
+        // ports found by name in clis_start have no known id yet
+        entry = clis_index_find_port(&context->index, port_id);
+        if(entry == NULL) {
+            entry = clis_index_find_name(&context->index,
+                    jack_port_name(port));
+        }
+        if(entry != NULL) {
+            clis_index_unbind(&context->index, entry);
+            update_subscribers(context, entry, NULL);
         }
     }
 
+    pthread_mutex_unlock(&context->routes_lock);
 }
 
 /**
@@ -152,21 +333,252 @@ add_mod_source(parameter *param)
     }
     param->mods.sources = tmp;
     param->mods.sources[param->mods.length].port = NULL;
+    param->mods.sources[param->mods.length].local = NULL;
+    param->mods.sources[param->mods.length].input = NULL;
     param->mods.length++;
 
     return &param->mods.sources[param->mods.length - 1];
 }
 
 
+/**
+ *  (Re)allocate the buses of every parameter so each can hold nframes samples.
+ *  They are rows of one block, structure of arrays, so evaluating a run of
+ *  parameters walks memory in order and none of them is allocated on its own.
+ *
+ *  @param context - the context owning the parameters
+ *  @param nframes - the new JACK buffer size
+ *  @return CLIS_OK or CLIS_E_ALLOC_BUS if the buses could not be allocated,
+ *  the previous buses are left intact in that case
+ */
+static clis_rc
+resize_mod_bus(clis_context *context, jack_nframes_t nframes)
+{
+    jack_default_audio_sample_t *tmp;
+    size_t i;
+
+    if(context->params_length == 0)
+        return CLIS_OK;
+
+    tmp = realloc(context->buses,
+            context->params_length * nframes * sizeof *tmp);
+    if(tmp == NULL) {
+        return CLIS_E_ALLOC_BUS;
+    }
+    context->buses = tmp;
+
+    for(i = 0; i < context->params_length; i++) {
+        context->params[i].bus = &context->buses[i * nframes];
+    }
+    context->bus_length = nframes;
+
+    return CLIS_OK;
+}
+
+/**
+ *  JACK buffer size callback. JACK does not run the process callback while the
+ *  buffer size is changing so it is safe to reallocate the mod bus here, this
+ *  keeps the allocator off the realtime thread.
+ */
+static int
+buffer_size_changed(jack_nframes_t nframes, void *arg)
+{
+    clis_context *context = (clis_context *)arg;
+
+    if(nframes == context->bus_length)
+        return 0;
+
+    return resize_mod_bus(context, nframes) == CLIS_OK ? 0 : 1;
+}
+
+/**
+ *  Allocate the routing table of every modulated parameter, large enough for
+ *  every configured mod source.
+ *
+ *  @param context - the context owning the parameters
+ *  @return CLIS_OK or CLIS_E_ALLOC_ROUTES
+ */
+static clis_rc
+alloc_routes(clis_context *context)
+{
+    unsigned int i;
+
+    for(i = 0; i < context->params_length; i++) {
+        parameter *param = &context->params[i];
+
+        param->routes.length = 0;
+
+        if(param->mods.length == 0)
+            continue;
+
+        param->routes.routes = calloc(param->mods.length,
+                sizeof *param->routes.routes);
+        if(param->routes.routes == NULL) {
+            return CLIS_E_ALLOC_ROUTES;
+        }
+    }
+
+    return CLIS_OK;
+}
+
+/**
+ *  Widen range to cover another range.
+ *
+ *  @param range - the range so far
+ *  @param any - false until the first range is merged, then true
+ *  @param with - the range to cover
+ */
+void
+clis_latency_widen(jack_latency_range_t *range, bool *any,
+                   jack_latency_range_t with)
+{
+    if(!*any) {
+        *range  = with;
+        *any    = true;
+        return;
+    }
+
+    if(with.min < range->min)
+        range->min = with.min;
+    if(with.max > range->max)
+        range->max = with.max;
+}
+
+/**
+ *  Widen range to cover the latency of port in mode, eg. the capture latency
+ *  of the sources connected to an input port. Ports without connections have
+ *  no latency to cover and are skipped.
+ */
+void
+clis_latency_merge(jack_latency_range_t *range, bool *any, jack_port_t *port,
+                   jack_latency_callback_mode_t mode)
+{
+    jack_latency_range_t port_range;
+
+    if(!jack_port_connected(port))
+        return;
+
+    jack_port_get_latency_range(port, mode, &port_range);
+    clis_latency_widen(range, any, port_range);
+}
+
+/**
+ *  Set the latency of port in mode to a merged range plus the latency of the
+ *  processing in between, nothing merged counts as no latency.
+ */
+void
+clis_latency_apply(jack_port_t *port, jack_latency_callback_mode_t mode,
+                   jack_latency_range_t range, bool any,
+                   jack_nframes_t latency)
+{
+    if(!any) {
+        range.min = 0;
+        range.max = 0;
+    }
+
+    range.min += latency;
+    range.max += latency;
+
+    jack_port_set_latency_range(port, mode, &range);
+}
+
+/**
+ *  JACK latency callback. The outputs lag the mod inputs by the clients
+ *  latency: in capture mode the inputs capture latency is passed on to the
+ *  outputs and in playback mode the outputs playback latency to the inputs.
+ */
+static void
+latency_changed(jack_latency_callback_mode_t mode, void *arg)
+{
+    clis_context *context = (clis_context *)arg;
+    jack_latency_range_t range = { 0, 0 };
+    bool any = false;
+    mod_source *source;
+    size_t i, j;
+
+    if(mode == JackCaptureLatency) {
+        for(i = 0; i < context->params_length; i++) {
+            for(j = 0; j < context->params[i].mods.length; j++) {
+                source = &context->params[i].mods.sources[j];
+                if(source->input)
+                    clis_latency_merge(&range, &any, source->input, mode);
+            }
+        }
+        for(i = 0; i < context->outputs_length; i++) {
+            clis_latency_apply(context->outputs[i], mode, range, any,
+                    context->latency);
+        }
+    } else {
+        for(i = 0; i < context->outputs_length; i++) {
+            clis_latency_merge(&range, &any, context->outputs[i], mode);
+        }
+        for(i = 0; i < context->params_length; i++) {
+            for(j = 0; j < context->params[i].mods.length; j++) {
+                source = &context->params[i].mods.sources[j];
+                if(source->input)
+                    clis_latency_apply(source->input, mode, range, any,
+                            context->latency);
+            }
+        }
+    }
+}
+
 clis_rc
 clis_start(clis_context *context) {
-    unsigned int i, j;
+    size_t i;
+    clis_rc rc;
+
+    sigset_t all, old;
+    int err;
+
+    pthread_mutex_init(&context->routes_lock, NULL);
+    pthread_cond_init(&context->connect_cond, NULL);
+
+    rc = alloc_routes(context);
+    if(rc) {
+        return rc;
+    }
+
+    if(clis_index_build(&context->index, context->params, 
+                context->params_length) != 0) {
+        return CLIS_E_ALLOC_INDEX;
+    }
+
+    rc = register_inputs(context);
+    if(rc) {
+        return rc;
+    }
 
     // make sure we can add modulation parameter ports when they are created
     // in future.
     jack_set_port_registration_callback(context->client, port_registered,
             context);
 
+    if(jack_set_latency_callback(context->client,
+                context->latency_cb ? context->latency_cb : latency_changed,
+                context->latency_cb ? context->latency_cb_arg : context) != 0) {
+        return CLIS_E_JACK_CALLBACK;
+    }
+
+    // the mod bus must be sized before the first process call and follow any
+    // later changes to the buffer size
+    rc = resize_mod_bus(context, jack_get_buffer_size(context->client));
+    if(rc) {
+        return rc;
+    }
+
+    if(jack_set_buffer_size_callback(context->client, buffer_size_changed, 
+                context) != 0) {
+        return CLIS_E_JACK_CALLBACK;
+    }
+
+    // every source is an input port or a local buffer by now, route them
+    // before the first process call
+    for(i = 0; i < context->params_length; i++) {
+        if(context->params[i].mods.length > 0)
+            build_routes(&context->params[i]);
+    }
+
     // at this point all of the jack callbacks should be registered and so it is
     // safe to 'activate' the client
     if (jack_activate(context->client)) {
@@ -174,26 +586,36 @@ clis_start(clis_context *context) {
     }
 
     // attempt to find jack ports that have been registered by other processes
-    // and add them to the parameters array so they can be processed as inputs
-    for(i = 0; i < context->params_length; i++) {
+    // and connect them now, so modulation is there from the first period, one
+    // lookup per distinct name. The registration callback may already be
+    // running so take the lock.
+    pthread_mutex_lock(&context->routes_lock);
 
-        parameter param = context->params[i];
+    for(i = 0; i < context->index.length; i++) {
+        clis_index_entry *entry = &context->index.entries[i];
+        jack_port_t *port = jack_port_by_name(context->client, entry->name);
 
-        printf("INTI %d mods\n", param.mods.length);
-        for(j = 0; j < param.mods.length; j++) {
+        if(port == NULL)
+            continue;
 
-            jack_port_t *port = jack_port_by_name(context->client, 
-                    param.mods.sources[j].name);
+        update_subscribers(context, entry, port);
+    }
+    context->connect_pending = false;
+    connect_sources(context);
 
-            if(port == NULL)
-                continue;
+    pthread_mutex_unlock(&context->routes_lock);
 
-            param.mods.sources[j].port = port;
+    // ports registered later are connected by the connector thread, signals
+    // are left to the main thread so they still interrupt clis_run
+    sigfillset(&all);
+    pthread_sigmask(SIG_SETMASK, &all, &old);
+    err = pthread_create(&context->connector, NULL, connector_main, context);
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
 
-            printf("INIT added mod source %s : %p\n", 
-                    param.mods.sources[j].name, param.mods.sources[j].port);
-        }
+    if(err != 0) {
+        return CLIS_E_CONNECTOR;
     }
+    context->connector_started = true;
 
     return CLIS_OK;
 }
@@ -223,6 +645,7 @@ clis_play_audio(jack_client_t *client, jack_port_t *output_port_l, jack_port_t *
     }
 
     jack_free(ports);
+    clis_render_add(output_port_l, output_port_r);
 
     return CLIS_OK;
 }
@@ -241,6 +664,12 @@ clis_rc_string(clis_rc rc)
             return "status ok";
         case CLIS_E_ALLOC_MOD: 
             return "could not allocate new modulation source";
+        case CLIS_E_ALLOC_BUS: 
+            return "could not allocate modulation bus";
+        case CLIS_E_ALLOC_ROUTES: 
+            return "could not allocate modulation routes";
+        case CLIS_E_ALLOC_INDEX: 
+            return "could not allocate modulation port index";
         case CLIS_E_PARSE_PARAM: 
             return "could not parse param string";
         case CLIS_E_JACK_CLIENT_OPEN:
@@ -257,12 +686,58 @@ clis_rc_string(clis_rc rc)
             return "no physical playback ports";
         case CLIS_E_CONNECT_OUTPUT_PORT:
             return "cannot connect output ports\n";
+        case CLIS_E_REGISTER_PORT:
+            return "could not register port";
+        case CLIS_E_PATCH_SYNTAX:
+            return "could not parse patch";
+        case CLIS_E_UNKNOWN_GEN:
+            return "unknown generator";
+        case CLIS_E_UNKNOWN_OUTPUT:
+            return "unknown generator output";
+        case CLIS_E_NODE_CYCLE:
+            return "generators modulate each other in a loop";
+        case CLIS_E_ALLOC_NODE:
+            return "could not allocate generator";
+        case CLIS_E_START_WORKERS:
+            return "could not start worker threads";
+        case CLIS_E_ALLOC_RENDER:
+            return "could not allocate render buffer";
+        case CLIS_E_RENDER_FILE:
+            return "could not write render file";
+        case CLIS_E_FREEWHEEL:
+            return "could not start freewheeling";
+        case CLIS_E_CONTROL:
+            return "could not start control thread";
+        case CLIS_E_CONTROL_SOCKET:
+            return "could not open control socket";
+        case CLIS_E_CONNECTOR:
+            return "could not start mod source connector";
+        case CLIS_E_STATS:
+            return "could not start dsp load reporter";
         default :
             return "unkown error";
     }
 }
 
 
+/**
+ * Set a parameter to its definitions defaults, without mod sources.
+ *
+ * @param param - the parameter to set
+ * @param def - the definition of the parameter
+ */
+void
+clis_param_init(parameter *param, const clis_param_def *def)
+{
+    memset(param, 0, sizeof *param);
+    param->value        = def->value;
+    param->min          = def->min;
+    param->max          = def->max;
+    param->mod_scale    = def->mod_scale;
+    param->rate         = def->rate;
+    param->smoothing    = def->smoothing;
+}
+
 /**
  * Set the mod_source properties according to the arg string and the globally
  * defined defaults.
@@ -273,8 +748,12 @@ clis_rc_string(clis_rc rc)
  *   - client:value
  *   - client:port
  *   - client:port:value
+ *   - @rate
+ *   - @rate:smoothing
  *  value will be cast to a float, client and port strings are limited to 32
- *  char each as per the JACK limits.
+ *  char each as per the JACK limits. rate sets the frames between control
+ *  points and smoothing is one of none, linear or onepole, see
+ *  clis_param_segment.
  * @param param - a new modulation source will be added accordingly. The
  *  caller is responsible for freeing the mod_source name string. And the 
  *  modulation sources array.
@@ -287,7 +766,26 @@ clis_parse_param_string(char *arg, parameter *param)
     char  client[32];
     char  port[32];
     float value = 0;
+    unsigned int rate;
+    int end = 0;
   
+    if(arg[0] == '@') {
+        if(sscanf(arg, "@%u%n", &rate, &end) != 1)
+            return CLIS_E_PARSE_PARAM;
+
+        if(arg[end] == '\0' || strcmp(arg + end, ":none") == 0)
+            param->smoothing = CLIS_SMOOTH_NONE;
+        else if(strcmp(arg + end, ":linear") == 0)
+            param->smoothing = CLIS_SMOOTH_LINEAR;
+        else if(strcmp(arg + end, ":onepole") == 0)
+            param->smoothing = CLIS_SMOOTH_ONEPOLE;
+        else
+            return CLIS_E_PARSE_PARAM;
+
+        param->rate = rate;
+        return 0;
+    }
+
     // NOTE that we only set the matched properties as the others will have 
     // incorrect matches from previous runs of sscanf
     if(sscanf(arg, "%32[^:]:%32[^:]:%f", client, port, &value) == 3) {
@@ -322,47 +820,278 @@ clis_parse_param_string(char *arg, parameter *param)
     return 0;
 }
 
+/**
+ *  Multiply-accumulate a modulation source into the bus. Kept free of
+ *  aliasing and branches so the compiler can vectorise it.
+ */
+static inline void
+mod_mac(jack_default_audio_sample_t *restrict out,
+        const jack_default_audio_sample_t *restrict in, float gain,
+        jack_nframes_t nframes)
+{
+    jack_nframes_t i;
+
+    for(i = 0; i < nframes; i++) {
+        out[i] += in[i] * gain;
+    }
+}
+
+/**
+ *  Scale the first modulation source into the bus, this saves clearing the bus
+ *  before accumulating the rest of the sources.
+ */
+static inline void
+mod_scale(jack_default_audio_sample_t *restrict out,
+          const jack_default_audio_sample_t *restrict in, float gain,
+          jack_nframes_t nframes)
+{
+    jack_nframes_t i;
+
+    for(i = 0; i < nframes; i++) {
+        out[i] = in[i] * gain;
+    }
+}
+
 // TODO : adapt this so that it works with midi sources and constant sources
-// TODO : find out if its ok to read the output-port buffers like this or if
-// they should first be connected to an input-port on this client.
 /**
  *  return a buffer of all the mod sources combined for a single parameters 
- *  modulation sources
+ *  modulation sources. 
+ *
+ *  This is called from the process callback and so never allocates, the sum is
+ *  written to the parameters preallocated mod bus.
  *
  *  @param nframes - the length of the requested buffer
- *  @param mods - the modulation sources to sample
- *  @return - a pointer to the sampled buffer, the caller must free the buffer
+ *  @param param - the parameter whose modulation sources are sampled
+ *  @return - a pointer to the parameters mod bus or NULL if the parameter is
+ *  not modulated. The buffer is owned by the parameter and is only valid until
+ *  the next call.
  */
 jack_default_audio_sample_t *
-clis_get_mod_buffer(jack_nframes_t nframes, mod_source_arr *mods)
+clis_get_mod_buffer(jack_nframes_t nframes, parameter *param)
 {
-    unsigned int i, j;
-    jack_default_audio_sample_t *out = NULL, *mod = NULL;
-    jack_port_t *port;
+    return clis_get_mod_block(0, nframes, param);
+}
 
-    if(mods->length > 0) {
-        out = calloc(nframes, sizeof *out); 
+/**
+ *  the same as clis_get_mod_buffer for the frames offset to offset + nframes
+ *  of the current period, for rendering a period in sub-blocks. Local sources
+ *  are read at the same offset. The result starts at the start of the bus.
+ */
+jack_default_audio_sample_t *
+clis_get_mod_block(jack_nframes_t offset, jack_nframes_t nframes,
+                   parameter *param)
+{
+    unsigned int i;
+    jack_default_audio_sample_t *out = param->bus, *mod = NULL;
+    const mod_routes *routes = &param->routes;
+    const mod_route  *route;
 
-        for(i = 0; i < mods->length; i++) {
-            port = mods->sources[i].port;
+    if(param->mods.length == 0 || out == NULL)
+        return NULL;
 
-            // ports may not be registered yet
-            if (port == NULL)
-                continue;
+    if(routes->length == 0) {
+        memset(out, 0, nframes * sizeof *out);
+    }
 
-            mod = (jack_default_audio_sample_t*)
-                   jack_port_get_buffer(mods->sources[i].port, nframes);
+    for(i = 0; i < routes->length; i++) {
+        route = &routes->routes[i];
+        mod = route->local
+            ? *route->local
+            : (jack_default_audio_sample_t*)
+               jack_port_get_buffer(route->port, offset + nframes);
+        mod += offset;
 
-            for(j = 0; j < nframes; j++) {
-                // TODO dynamic sample rate
-                out[j] += mod[j] * mods->sources[i].value * 44100;
-            }
+        if(i == 0) {
+            mod_scale(out, mod, route->gain, nframes);
+        } else {
+            mod_mac(out, mod, route->gain, nframes);
         }
     }
 
     return out;
 }
 
+/**
+ *  Add a value to a modulation in place and clamp it, branch free so the
+ *  compiler can vectorise it.
+ */
+static inline void
+eval_mod(jack_default_audio_sample_t *restrict out, float value, float min,
+         float max, jack_nframes_t nframes)
+{
+    jack_nframes_t i;
+    float x;
+
+    for(i = 0; i < nframes; i++) {
+        x = out[i] + value;
+        x = x < min ? min : x;
+        out[i] = x > max ? max : x;
+    }
+}
+
+static inline void
+eval_fill(jack_default_audio_sample_t *restrict out, float value,
+          jack_nframes_t nframes)
+{
+    jack_nframes_t i;
+
+    for(i = 0; i < nframes; i++) {
+        out[i] = value;
+    }
+}
+
+/**
+ *  Evaluate a run of parameters for the frames offset to offset + nframes of
+ *  the current period: each parameters value plus its modulation, clamped to
+ *  its range. The results are rows of the contexts buses so the run is
+ *  evaluated in one pass over contiguous memory with no branches per frame.
+ *
+ *  Called from the process callback, this never allocates.
+ *
+ *  @param params - the parameters, eg. the slice belonging to one generator
+ *  @param params_length - the number of parameters
+ *  @param offset - the first frame of the block in the period
+ *  @param nframes - the block length
+ *  @param values - set to the row of each parameter, valid until the next
+ *  call for the same parameters
+ */
+void
+clis_eval_params(parameter *params, size_t params_length,
+                 jack_nframes_t offset, jack_nframes_t nframes,
+                 jack_default_audio_sample_t **values)
+{
+    parameter *param;
+    float value;
+    size_t p;
+
+    for(p = 0; p < params_length; p++) {
+        param       = &params[p];
+        values[p]   = param->bus;
+
+        if(clis_get_mod_block(offset, nframes, param) != NULL) {
+            eval_mod(param->bus, param->value, param->min, param->max,
+                    nframes);
+        } else {
+            value = param->value;
+            value = value < param->min ? param->min : value;
+            value = value > param->max ? param->max : value;
+            eval_fill(param->bus, value, nframes);
+        }
+    }
+}
+
+/**
+ *  Step a parameter through a block at its control rate. Returns how many
+ *  frames from frame i the parameter can be set once for, so setters and
+ *  coefficients are recomputed once per control point rather than per frame:
+ *
+ *      for(i = 0; i < nframes; i += n) {
+ *          n = clis_param_segment(param, values, i, nframes, &segment);
+ *          ... set from segment.value, then render n frames ...
+ *      }
+ *
+ *  At a control point the parameter heads for its value on that frame. Between
+ *  points it moves by segment.step a frame, which a
+ *  generator may add to a quantity linear in the parameter, such as a phase
+ *  increment, or ignore. A parameter without a control rate is sampled every
+ *  frame it is modulated and set once per block when it is not. A change of
+ *  the parameters value, eg. by a control event, takes a new point at once.
+ *
+ *  @param param - the parameter, its control state is advanced past the
+ *  segment
+ *  @param values - the parameters row from clis_eval_params
+ *  @param i - the first frame of the segment
+ *  @param nframes - the block length
+ *  @param segment - set to the value and step of the segment
+ *  @return the segment length, at least 1 frame
+ */
+jack_nframes_t
+clis_param_segment(parameter *param, const jack_default_audio_sample_t *values,
+                   jack_nframes_t i, jack_nframes_t nframes,
+                   clis_segment *segment)
+{
+    bool modulated = param->mods.length > 0;
+    float target, next;
+    jack_nframes_t n = nframes - i;
+
+    if(param->rate == 0) {
+        segment->value  = values[i];
+        segment->step   = 0;
+        return modulated ? 1 : n;
+    }
+
+    if(!param->ctl_ready || param->ctl_left == 0 ||
+            param->ctl_base != param->value) {
+        target = values[i];
+
+        if(!param->ctl_ready) {
+            // start on the first point rather than gliding from zero
+            param->ctl_value    = target;
+            param->ctl_ready    = true;
+        }
+
+        switch(param->smoothing) {
+            case CLIS_SMOOTH_LINEAR:
+                next = target;
+                break;
+            case CLIS_SMOOTH_ONEPOLE:
+                next = param->ctl_value + 0.25f * (target - param->ctl_value);
+                // settle rather than creep towards the target forever
+                if(fabsf(target - next) <= 1e-6f * fabsf(target))
+                    next = target;
+                break;
+            default:
+                param->ctl_value = target;
+                next = target;
+                break;
+        }
+
+        param->ctl_next = next;
+        param->ctl_step = (next - param->ctl_value) / (float)param->rate;
+        param->ctl_base = param->value;
+        param->ctl_left = param->rate;
+    }
+
+    // a settled parameter that is not modulated needs no more points
+    if(!modulated && param->ctl_step == 0) {
+        param->ctl_left = 0;
+    } else if(n > param->ctl_left) {
+        n = param->ctl_left;
+    }
+
+    segment->value = param->ctl_value;
+    segment->step  = param->ctl_step;
+
+    if(param->ctl_left) {
+        param->ctl_left  -= n;
+        // land on the point exactly, the steps do not add up to it
+        param->ctl_value = param->ctl_left
+            ? param->ctl_value + param->ctl_step * (float)n
+            : param->ctl_next;
+    }
+
+    return n;
+}
+
+/**
+ *  The per frame step of a segment scaled into a quantity that is never
+ *  negative, eg. a phase increment, whose setter clamps it at zero.
+ *
+ *  @param segment - a segment from clis_param_segment
+ *  @param n - the segment length
+ *  @param scale - eg. 2^32 / sample rate for a frequency to a 32 bit phase
+ *  increment
+ *  @return the scaled step or 0 if the segment ramps below zero
+ */
+float
+clis_segment_ramp(const clis_segment *segment, jack_nframes_t n, float scale)
+{
+    if(segment->value < 0 || segment->value + segment->step * (float)n < 0)
+        return 0;
+
+    return segment->step * scale;
+}
+
 /**
  *  free the jack client if it exists.
  *
@@ -376,16 +1105,38 @@ void
 clis_close(clis_context *ctx)
 {
     size_t i, j;
+
+    // the connector calls into the client so stop it first
+    if(ctx->connector_started) {
+        pthread_mutex_lock(&ctx->routes_lock);
+        ctx->connector_quit = true;
+        pthread_cond_signal(&ctx->connect_cond);
+        pthread_mutex_unlock(&ctx->routes_lock);
+        pthread_join(ctx->connector, NULL);
+        ctx->connector_started = false;
+    }
+
+    // the reporter asks the client its name
+    clis_stats_stop();
+
     // client may not be initialised 
     if(ctx->client) {
         printf("closing client\n");
         jack_client_close(ctx->client);
     }
 
+    clis_render_free();
+
     for(i = 0; i < ctx->params_length; i++) {
         for(j = 0; j < ctx->params[i].mods.length; j++) {
             free(ctx->params[i].mods.sources[j].name);
         }
         free(ctx->params[i].mods.sources);
+        free(ctx->params[i].routes.routes);
     }
+
+    free(ctx->buses);
+    ctx->buses = NULL;
+
+    clis_index_free(&ctx->index);
 }
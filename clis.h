@@ -1,6 +1,11 @@
 #ifndef CLIS_INC
 #define CLIS_INC
 
+#include <pthread.h>
+#include <stdbool.h>
+
+#include "clis_index.h"
+
 struct jack_port_t;
 struct jack_nframes_t;
 
@@ -8,18 +13,41 @@ typedef enum clis_rc {
     CLIS_OK         = 0,
     CLIS_E_PARSE_PARAM,
     CLIS_E_ALLOC_MOD,
+    CLIS_E_ALLOC_BUS,
+    CLIS_E_ALLOC_ROUTES,
+    CLIS_E_ALLOC_INDEX,
     CLIS_E_JACK_CLIENT_OPEN,
     CLIS_E_JACK_CONNECT,
     CLIS_E_JACK_CALLBACK,
     CLIS_E_NAME_TAKEN,
     CLIS_E_CLIENT_ACTIVATE,
     CLIS_E_NO_OUTPUT_PORTS,
-    CLIS_E_CONNECT_OUTPUT_PORT
+    CLIS_E_CONNECT_OUTPUT_PORT,
+    CLIS_E_REGISTER_PORT,
+    CLIS_E_PATCH_SYNTAX,
+    CLIS_E_UNKNOWN_GEN,
+    CLIS_E_UNKNOWN_OUTPUT,
+    CLIS_E_NODE_CYCLE,
+    CLIS_E_ALLOC_NODE,
+    CLIS_E_START_WORKERS,
+    CLIS_E_ALLOC_RENDER,
+    CLIS_E_RENDER_FILE,
+    CLIS_E_FREEWHEEL,
+    CLIS_E_CONTROL,
+    CLIS_E_CONTROL_SOCKET,
+    CLIS_E_CONNECTOR,
+    CLIS_E_STATS
 } clis_rc;
 
 typedef struct mod_source {
     char        *name;
+    // the source port while it exists and the input port of this client that
+    // is connected to it, the modulation is read from the input
     jack_port_t *port;
+    jack_port_t *input;
+    // set when the source is a buffer rendered in this process, the buffer is
+    // read through this pointer each cycle and port is unused
+    jack_default_audio_sample_t **local;
     float        value;
 } mod_source;
 
@@ -28,15 +56,103 @@ typedef struct mod_source_arr {
     mod_source *sources;
 } mod_source_arr;
 
+// a resolved modulation source as seen by the process thread
+typedef struct mod_route {
+    jack_port_t *port;
+    jack_default_audio_sample_t **local;
+    float        gain;
+} mod_route;
+
+// the resolved modulation sources of a parameter
+typedef struct mod_routes {
+    size_t      length;
+    mod_route   *routes;
+} mod_routes;
+
+// how a parameter at a control rate moves from one control point to the next
+typedef enum clis_smoothing {
+    CLIS_SMOOTH_NONE    = 0,    // jumps, the modulation is sampled and held
+    CLIS_SMOOTH_LINEAR,         // ramps to each point over one control period
+    CLIS_SMOOTH_ONEPOLE         // glides, a quarter of the way each point
+} clis_smoothing;
+
+// frames a parameter is set once for, see clis_param_segment
+typedef struct clis_segment {
+    float value;        // the value on the first frame
+    float step;         // added to the value on every frame after the first
+} clis_segment;
+
+// a parameter as declared by a program or generator, see clis_param_init
+typedef struct clis_param_def {
+    const char      *name;
+    char            opt;        // command line flag, eg. 'f' for -f
+    float           value;      // default value
+    float           min;        // the range the parameter is clamped to
+    float           max;
+    float           mod_scale;  // see parameter.mod_scale
+    jack_nframes_t  rate;       // default control rate, see parameter.rate
+    clis_smoothing  smoothing;
+} clis_param_def;
+
 typedef struct parameter {
     float value;
+    // the value plus modulation is clamped to this range
+    float min;
+    float max;
+    // sources are scaled by their value times mod_scale
+    float mod_scale;
     mod_source_arr mods;
+    // frames between control points, 0 follows the modulation every frame
+    jack_nframes_t rate;
+    clis_smoothing smoothing;
+    // the control point state, only used by the process thread
+    bool            ctl_ready;
+    float           ctl_value;      // the value on the next frame
+    float           ctl_step;
+    float           ctl_next;       // the value on the next control point
+    float           ctl_base;       // value when the last point was taken
+    jack_nframes_t  ctl_left;       // frames until the next control point
+    // the parameters row of the contexts buses. The mod sources are summed
+    // into it, then clis_eval_params leaves the value of each frame in it
+    jack_default_audio_sample_t *bus;
+    // the routing table read by the process thread, built once by clis_start
+    // before the client is activated. A route reads one of this clients own
+    // input ports or a local buffer, neither changes when other ports come
+    // and go, so the table never does
+    mod_routes routes;
 } parameter;
 
 typedef struct clis_context {
     size_t          params_length;
     parameter       *params;
+    // optional, names the mod input ports of each parameter, eg. 'freq.mod0'
+    const char *const *names;
+    // the outputs of the client and the frames they lag its inputs, reported
+    // to JACK so that latency can be compensated across a chain of clients
+    size_t          outputs_length;
+    jack_port_t     **outputs;
+    jack_nframes_t  latency;
+    // optional, replaces the latency callback that reports the above
+    JackLatencyCallback latency_cb;
+    void            *latency_cb_arg;
     jack_client_t   *client;
+    // one row of bus_length frames per parameter, see clis_eval_params
+    jack_default_audio_sample_t *buses;
+    // length of each parameters mod bus, tracks the JACK buffer size
+    jack_nframes_t  bus_length;
+    // serialises the registration callback and the connector thread over the
+    // index and the ports the mod sources follow, the process thread never
+    // takes it
+    pthread_mutex_t routes_lock;
+    // wakes the thread that connects mod sources as they appear, JACK
+    // callbacks may not connect ports themselves. Guarded by routes_lock
+    pthread_cond_t  connect_cond;
+    pthread_t       connector;
+    bool            connector_started;
+    bool            connector_quit;
+    bool            connect_pending;
+    // mod source port names to the parameters that follow them
+    clis_index      index;
 } clis_context;
 
 // lifecycle
@@ -46,12 +162,39 @@ clis_rc clis_init_client(char *client_name, char *server_name,
             JackSampleRateCallback srate_cb, void *srate_cb_arg);
 
 clis_rc clis_start(clis_context *ctx);
+void    clis_run(void);
+// cleared by the signal handlers to stop clis_run and clis_render
+extern int is_running;
 clis_rc clis_play_audio(jack_client_t *client, jack_port_t *output_port_l, jack_port_t *output_port_r);
 
+// latency
+void        clis_latency_widen(jack_latency_range_t *range, bool *any,
+                               jack_latency_range_t with);
+void        clis_latency_merge(jack_latency_range_t *range, bool *any,
+                               jack_port_t *port,
+                               jack_latency_callback_mode_t mode);
+void        clis_latency_apply(jack_port_t *port,
+                               jack_latency_callback_mode_t mode,
+                               jack_latency_range_t range, bool any,
+                               jack_nframes_t latency);
+
 // parameters
+void        clis_param_init(parameter *param, const clis_param_def *def);
 clis_rc     clis_parse_param_string(char *arg, parameter *param);
 jack_default_audio_sample_t *clis_get_mod_buffer(jack_nframes_t nframes, 
-                                                 mod_source_arr *mods);
+                                                 parameter *param);
+jack_default_audio_sample_t *clis_get_mod_block(jack_nframes_t offset,
+                                                jack_nframes_t nframes,
+                                                parameter *param);
+void        clis_eval_params(parameter *params, size_t params_length,
+                             jack_nframes_t offset, jack_nframes_t nframes,
+                             jack_default_audio_sample_t **values);
+jack_nframes_t clis_param_segment(parameter *param,
+                                  const jack_default_audio_sample_t *values,
+                                  jack_nframes_t i, jack_nframes_t nframes,
+                                  clis_segment *segment);
+float       clis_segment_ramp(const clis_segment *segment, jack_nframes_t n,
+                              float scale);
 void        clis_close(clis_context *ctx);
 
 // status codes
@@ -0,0 +1,415 @@
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "clis.h"
+#include "clis_control.h"
+
+#define CONTROL_DELIM   " \t\r\n"
+#define CONTROL_MASK    (CLIS_CONTROL_EVENTS - 1)
+
+// a control stream, stdin or a socket connection, and its partial line
+typedef struct control_reader {
+    int             fd;
+    size_t          length;
+    char            line[CLIS_CONTROL_LINE];
+} control_reader;
+
+/**
+ * Queue an event for the process thread. Called from the control thread only.
+ * When the ring is full this waits for the process thread to drain it, which
+ * it does every period, so no event is lost.
+ */
+static void
+push(clis_control *control, const clis_event *event)
+{
+    size_t head = atomic_load_explicit(&control->head, memory_order_relaxed);
+    struct timespec wait = { 0, 1000000 };
+
+    while(head - atomic_load_explicit(&control->tail, memory_order_acquire)
+            == CLIS_CONTROL_EVENTS) {
+        if(atomic_load(&control->quit))
+            return;
+        nanosleep(&wait, NULL);
+    }
+
+    control->events[head & CONTROL_MASK] = *event;
+    atomic_store_explicit(&control->head, head + 1, memory_order_release);
+}
+
+/**
+ * Look at the oldest event without taking it off the ring. Called from the
+ * process thread only.
+ *
+ * @return true if there is an event
+ */
+bool
+clis_control_peek(clis_control *control, clis_event *event)
+{
+    size_t tail = atomic_load_explicit(&control->tail, memory_order_relaxed);
+
+    if(tail == atomic_load_explicit(&control->head, memory_order_acquire))
+        return false;
+
+    *event = control->events[tail & CONTROL_MASK];
+
+    return true;
+}
+
+/**
+ * Take the oldest event off the ring. Called from the process thread only,
+ * this is wait-free and never blocks on the control thread.
+ *
+ * @return true if an event was taken
+ */
+bool
+clis_control_pop(clis_control *control, clis_event *event)
+{
+    size_t tail = atomic_load_explicit(&control->tail, memory_order_relaxed);
+
+    if(!clis_control_peek(control, event))
+        return false;
+
+    atomic_store_explicit(&control->tail, tail + 1, memory_order_release);
+
+    return true;
+}
+
+/**
+ * Render a period, split at the frame of every event due in it so that each
+ * change takes effect on exactly the frame it was stamped with. Events that
+ * are late take effect at the start of the period. Called from the process
+ * callback in place of rendering the whole period at once.
+ *
+ * @param control - the control whose events are applied
+ * @param nframes - the period length
+ * @param render - renders one sub-block of the period
+ * @param arg - passed to render
+ */
+void
+clis_control_process(clis_control *control, jack_nframes_t nframes,
+                     clis_control_render render, void *arg)
+{
+    jack_nframes_t start = control->client
+        ? jack_last_frame_time(control->client)
+        : 0;
+    jack_nframes_t offset = 0, next;
+    clis_event event;
+    int32_t due;
+
+    while(offset < nframes) {
+        next = nframes;
+
+        while(clis_control_peek(control, &event)) {
+            // frame times wrap, the difference does not
+            due = (int32_t)(event.time - start);
+
+            if(due > (int32_t)offset) {
+                if(due < (int32_t)nframes)
+                    next = (jack_nframes_t)due;
+                break;
+            }
+
+            control->params[event.param].value = event.value;
+            clis_control_pop(control, &event);
+        }
+
+        render(arg, offset, next - offset);
+        offset = next;
+    }
+}
+
+/**
+ * Parse one control line in the format:
+ *
+ *   [param] value
+ *
+ * eg. 'freq 440'. Without a parameter name the value sets the first
+ * parameter. Bad lines are reported on stderr and skipped.
+ *
+ * The change is stamped one period after the current frame time. That is the
+ * earliest frame every change can still be rendered on, so each one has the
+ * same latency whatever the period length.
+ */
+static void
+parse_line(clis_control *control, char *line)
+{
+    char *save = NULL, *name, *arg, *end;
+    clis_event event = { 0, 0, 0 };
+
+    name    = strtok_r(line, CONTROL_DELIM, &save);
+    arg     = strtok_r(NULL, CONTROL_DELIM, &save);
+
+    if(name == NULL)
+        return;
+
+    if(arg == NULL) {
+        arg = name;
+    } else {
+        for(event.param = 0; event.param < control->params_length;
+                event.param++) {
+            if(strcmp(control->names[event.param], name) == 0)
+                break;
+        }
+        if(event.param == control->params_length) {
+            fprintf(stderr, "control: unknown parameter %s\n", name);
+            return;
+        }
+    }
+
+    event.value = strtof(arg, &end);
+    if(end == arg || *end != '\0' || control->params_length == 0) {
+        fprintf(stderr, "control: bad value %s\n", arg);
+        return;
+    }
+
+    event.time = control->client
+        ? jack_frame_time(control->client) +
+          jack_get_buffer_size(control->client)
+        : 0;
+
+    push(control, &event);
+}
+
+/**
+ * Read what is available on a stream and parse every complete line.
+ *
+ * @return false once the stream is closed
+ */
+static bool
+read_stream(clis_control *control, control_reader *reader)
+{
+    char *newline;
+    size_t used;
+    ssize_t n;
+
+    n = read(reader->fd, reader->line + reader->length,
+            sizeof reader->line - 1 - reader->length);
+    if(n < 0 && errno == EINTR)
+        return true;
+    if(n <= 0)
+        return false;
+
+    reader->length += (size_t)n;
+    reader->line[reader->length] = '\0';
+
+    while((newline = strchr(reader->line, '\n')) != NULL) {
+        *newline = '\0';
+        used = (size_t)(newline - reader->line) + 1;
+        parse_line(control, reader->line);
+        memmove(reader->line, reader->line + used, reader->length - used + 1);
+        reader->length -= used;
+    }
+
+    // a line too long for the buffer is dropped
+    if(reader->length == sizeof reader->line - 1)
+        reader->length = 0;
+
+    return true;
+}
+
+static void *
+control_main(void *arg)
+{
+    clis_control *control = (clis_control *)arg;
+    control_reader readers[1 + CLIS_CONTROL_CLIENTS];
+    struct pollfd fds[3 + CLIS_CONTROL_CLIENTS];
+    size_t readers_length = 0, polled, fds_length, i;
+    int fd;
+
+    if(control->use_stdin) {
+        readers[readers_length].fd      = STDIN_FILENO;
+        readers[readers_length].length  = 0;
+        readers_length++;
+    }
+
+    while(!atomic_load(&control->quit)) {
+        fds_length = 0;
+        fds[fds_length++] = (struct pollfd){ control->wake[0], POLLIN, 0 };
+        if(control->socket >= 0)
+            fds[fds_length++] = (struct pollfd){ control->socket, POLLIN, 0 };
+        for(i = 0; i < readers_length; i++) {
+            fds[fds_length++] = (struct pollfd){ readers[i].fd, POLLIN, 0 };
+        }
+
+        if(poll(fds, fds_length, -1) < 0) {
+            if(errno == EINTR)
+                continue;
+            break;
+        }
+
+        if(fds[0].revents)
+            break;
+
+        // the streams polled are the last fds, a new connection comes after
+        polled = readers_length;
+
+        if(control->socket >= 0 && fds[1].revents & POLLIN) {
+            fd = accept(control->socket, NULL, NULL);
+            if(fd >= 0 && readers_length == 1 + CLIS_CONTROL_CLIENTS) {
+                close(fd);
+            } else if(fd >= 0) {
+                readers[readers_length].fd      = fd;
+                readers[readers_length].length  = 0;
+                readers_length++;
+            }
+        }
+
+        // streams are checked from the end so closed ones can be swapped out
+        for(i = polled; i-- > 0;) {
+            short revents = fds[fds_length - polled + i].revents;
+
+            if(revents == 0 || read_stream(control, &readers[i]))
+                continue;
+
+            if(readers[i].fd != STDIN_FILENO)
+                close(readers[i].fd);
+            readers[i] = readers[--readers_length];
+        }
+    }
+
+    for(i = 0; i < readers_length; i++) {
+        if(readers[i].fd != STDIN_FILENO)
+            close(readers[i].fd);
+    }
+
+    return NULL;
+}
+
+static int
+open_socket(const char *path)
+{
+    struct sockaddr_un addr;
+    int fd;
+
+    if(strlen(path) >= sizeof addr.sun_path)
+        return -1;
+
+    memset(&addr, 0, sizeof addr);
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if(fd < 0)
+        return -1;
+
+    // a socket left behind by a previous run would make bind fail
+    unlink(path);
+
+    if(bind(fd, (struct sockaddr *)&addr, sizeof addr) != 0 ||
+            listen(fd, CLIS_CONTROL_CLIENTS) != 0) {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+/**
+ * Start a thread that reads control lines from stdin and or a UNIX socket and
+ * queues them for the process thread, which applies them as it renders with
+ * clis_control_process.
+ *
+ * @param control - the control to start, must be zeroed
+ * @param client - the client whose process callback applies the changes
+ * @param params - the parameters the stream controls
+ * @param names - the name of each parameter in the stream
+ * @param params_length - the number of parameters
+ * @param use_stdin - read control lines from stdin
+ * @param socket_path - listen for control connections here or NULL
+ * @return CLIS_OK or an error code according to clis_rc
+ */
+clis_rc
+clis_control_start(clis_control *control, jack_client_t *client,
+                   parameter *params, const char *const *names,
+                   size_t params_length, bool use_stdin,
+                   const char *socket_path)
+{
+    sigset_t all, old;
+    int rc;
+
+    control->client         = client;
+    control->params         = params;
+    control->names          = names;
+    control->params_length  = params_length;
+    control->use_stdin      = use_stdin;
+    control->socket         = -1;
+    control->wake[0]        = -1;
+    control->wake[1]        = -1;
+    atomic_init(&control->head, 0);
+    atomic_init(&control->tail, 0);
+    atomic_init(&control->quit, false);
+
+    if(socket_path != NULL) {
+        control->socket_path = strdup(socket_path);
+        if(control->socket_path == NULL)
+            return CLIS_E_CONTROL;
+
+        control->socket = open_socket(socket_path);
+        if(control->socket < 0)
+            return CLIS_E_CONTROL_SOCKET;
+    }
+
+    if(pipe(control->wake) != 0)
+        return CLIS_E_CONTROL;
+
+    // signals are left to the main thread so they still interrupt clis_run
+    sigfillset(&all);
+    pthread_sigmask(SIG_SETMASK, &all, &old);
+    rc = pthread_create(&control->thread, NULL, control_main, control);
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+
+    if(rc != 0)
+        return CLIS_E_CONTROL;
+
+    control->started = true;
+
+    return CLIS_OK;
+}
+
+/**
+ * Stop the control thread and close its streams.
+ */
+void
+clis_control_stop(clis_control *control)
+{
+    ssize_t n;
+
+    // never started
+    if(control->names == NULL)
+        return;
+
+    if(control->started) {
+        atomic_store(&control->quit, true);
+        n = write(control->wake[1], "", 1);
+        (void)n;
+        pthread_join(control->thread, NULL);
+        control->started = false;
+    }
+
+    if(control->wake[0] >= 0) {
+        close(control->wake[0]);
+        close(control->wake[1]);
+    }
+
+    if(control->socket >= 0) {
+        close(control->socket);
+        unlink(control->socket_path);
+    }
+
+    free(control->socket_path);
+    control->socket_path    = NULL;
+    control->socket         = -1;
+    control->wake[0]        = -1;
+    control->wake[1]        = -1;
+    control->names          = NULL;
+}
@@ -0,0 +1,57 @@
+#ifndef CLIS_CONTROL_INC
+#define CLIS_CONTROL_INC
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <jack/jack.h>
+
+#include "clis.h"
+
+#define CLIS_CONTROL_EVENTS     1024    // ring capacity, a power of two
+#define CLIS_CONTROL_CLIENTS    8       // socket connections served at once
+#define CLIS_CONTROL_LINE       256     // longest control line
+
+// a parameter change, sent from the control thread to the process thread
+typedef struct clis_event {
+    size_t          param;
+    float           value;
+    jack_nframes_t  time;           // the frame the change takes effect on
+} clis_event;
+
+// renders the frames offset to offset + nframes of the current period
+typedef void (*clis_control_render)(void *arg, jack_nframes_t offset,
+                                    jack_nframes_t nframes);
+
+// a control stream reader and the wait-free ring it fills
+typedef struct clis_control {
+    jack_client_t       *client;        // the clock events are stamped with
+    size_t              params_length;
+    parameter           *params;
+    const char *const   *names;         // one per parameter, eg. 'freq'
+    // single producer single consumer ring, the head and tail are on their
+    // own cache lines so the two threads do not share one
+    clis_event          events[CLIS_CONTROL_EVENTS];
+    _Alignas(64) atomic_size_t head;    // written by the control thread
+    _Alignas(64) atomic_size_t tail;    // written by the process thread
+    _Alignas(64) int    wake[2];        // pipe that stops the control thread
+    bool                use_stdin;
+    char                *socket_path;
+    int                 socket;
+    pthread_t           thread;
+    bool                started;
+    atomic_bool         quit;
+} clis_control;
+
+clis_rc clis_control_start(clis_control *control, jack_client_t *client,
+                           parameter *params, const char *const *names,
+                           size_t params_length, bool use_stdin,
+                           const char *socket_path);
+bool    clis_control_peek(clis_control *control, clis_event *event);
+bool    clis_control_pop(clis_control *control, clis_event *event);
+void    clis_control_process(clis_control *control, jack_nframes_t nframes,
+                             clis_control_render render, void *arg);
+void    clis_control_stop(clis_control *control);
+
+#endif // CLIS_CONTROL_INC
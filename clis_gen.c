@@ -0,0 +1,587 @@
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <jack/jack.h>
+#include <jack/midiport.h>
+#include "OOPS/Inc/OOPS.h"
+
+#include "clis.h"
+#include "clis_gen.h"
+#include "clis_poly.h"
+
+// TODO dynamic sample rate
+#define FREQ_MOD_SCALE  44100
+#define FREQ_MAX        20000
+
+#define LENGTH(arr) (sizeof (arr) / sizeof *(arr))
+
+/* osc: band limited oscillator, the same voice as the main program. its four
+ * waves share one phasor */
+
+static const clis_param_def osc_params[] = {
+    { "freq", 'f', 200, 0, FREQ_MAX, FREQ_MOD_SCALE, 0, CLIS_SMOOTH_NONE },
+    { "amp",  'a', 1,   0, 1,        1,              0, CLIS_SMOOTH_NONE }
+};
+
+static const char *const osc_outputs[] = { "saw", "sqr", "tri", "sin" };
+
+static void *
+osc_init(void)
+{
+    return tMultiOscInit();
+}
+
+static int
+osc_set_mode(void *state, const char *mode)
+{
+    tMultiOsc *osc = (tMultiOsc *)state;
+    OscMode band;
+
+    if(strcmp(mode, "table") == 0)          band = OscModeWavetable;
+    else if(strcmp(mode, "blep") == 0)      band = OscModePolyBLEP;
+    else                                    return 1;
+
+    tMultiOscSetMode(osc, band);
+
+    return 0;
+}
+
+// scales the frames first to first + n of the four outputs by amp
+static void
+osc_apply_amp(jack_default_audio_sample_t **outputs,
+        const jack_default_audio_sample_t *amp, jack_nframes_t first,
+        jack_nframes_t n)
+{
+    jack_nframes_t j;
+    size_t k;
+
+    for(k = 0; k < 4; k++) {
+        for(j = first; j < first + n; j++) {
+            outputs[k][j] *= amp[j];
+        }
+    }
+}
+
+static void
+osc_process(void *state, parameter *params,
+        jack_default_audio_sample_t **values,
+        jack_default_audio_sample_t **outputs, jack_nframes_t nframes)
+{
+    tMultiOsc *osc = (tMultiOsc *)state;
+    jack_default_audio_sample_t *saw_out = outputs[0], *sqr_out = outputs[1],
+                                *tri_out = outputs[2], *sin_out = outputs[3];
+    jack_default_audio_sample_t *freq = values[0], *amp = values[1];
+    float inc_scale = TWO_TO_32 / OOPSGetSampleRate();
+    int32_t inc;
+    clis_segment segment;
+    jack_nframes_t i, j, n;
+
+    // audio rate modulation sets the frequency of every frame
+    if(params[0].mods.length > 0 && params[0].rate == 0) {
+        tMultiOscTickBlock(osc, freq, saw_out, sqr_out, tri_out, sin_out,
+                nframes);
+        osc_apply_amp(outputs, amp, 0, nframes);
+        return;
+    }
+
+    // set once per segment, the increments ramp between control points
+    for(i = 0; i < nframes; i += n) {
+        n   = clis_param_segment(&params[0], freq, i, nframes, &segment);
+        inc = (int32_t)lrintf(clis_segment_ramp(&segment, n, inc_scale));
+
+        tMultiOscSetFreq(osc, segment.value);
+
+        // a held frequency is rendered a block at a time
+        if(inc == 0) {
+            tMultiOscTickBlock(osc, NULL, saw_out + i, sqr_out + i,
+                    tri_out + i, sin_out + i, n);
+            continue;
+        }
+
+        for(j = i; j < i + n; j++) {
+            tMultiOscTick(osc, saw_out + j, sqr_out + j, tri_out + j,
+                    sin_out + j);
+            osc->inc += inc;
+        }
+    }
+
+    osc_apply_amp(outputs, amp, 0, nframes);
+}
+
+/* lfo: one sine phasor with naive shapes derived from its phase, LFOs do not
+ * need band limiting and this saves three oscillators per instance */
+
+static const clis_param_def lfo_params[] = {
+    { "freq", 'f', 1, 0, FREQ_MAX, FREQ_MOD_SCALE, 0, CLIS_SMOOTH_NONE }
+};
+
+static const char *const lfo_outputs[] = { "saw", "sqr", "tri", "sin" };
+
+static void *
+lfo_init(void)
+{
+    return tCycleInit();
+}
+
+static void
+lfo_process(void *state, parameter *params,
+        jack_default_audio_sample_t **values,
+        jack_default_audio_sample_t **outputs, jack_nframes_t nframes)
+{
+    tCycle *lfo = (tCycle *)state;
+    jack_default_audio_sample_t *saw_out = outputs[0], *sqr_out = outputs[1],
+                                *tri_out = outputs[2], *sin_out = outputs[3];
+    float phase, inc_scale = TWO_TO_32 / OOPSGetSampleRate();
+    int32_t inc;
+    clis_segment segment;
+    jack_nframes_t i, j, n;
+
+    for(i = 0; i < nframes; i += n) {
+        n   = clis_param_segment(&params[0], values[0], i, nframes, &segment);
+        inc = (int32_t)lrintf(clis_segment_ramp(&segment, n, inc_scale));
+
+        tCycleSetFreq(lfo, segment.value);
+
+        for(j = i; j < i + n; j++) {
+            sin_out[j]  = tCycleTick(lfo);
+            phase       = (float)(lfo->phase >> 8) * INV_TWO_TO_24;
+            saw_out[j]  = 2.0f * phase - 1.0f;
+            sqr_out[j]  = phase < 0.5f ? 1.0f : -1.0f;
+            tri_out[j]  = 1.0f - 4.0f * fabsf(phase - 0.5f);
+            lfo->inc   += inc;
+        }
+    }
+}
+
+/* filter: state variable filter on an audio input */
+
+// the coefficients cost a tan() to recompute, so modulation is followed at a
+// control rate by default
+static const clis_param_def filter_params[] = {
+    { "in",   'i', 0,    -INFINITY, INFINITY, 1, 0, CLIS_SMOOTH_NONE },
+    { "freq", 'f', 1000, 1, FREQ_MAX, FREQ_MOD_SCALE, 16, CLIS_SMOOTH_LINEAR },
+    { "res",  'q', 0.5f, 0.01f, 10,   1,              16, CLIS_SMOOTH_LINEAR }
+};
+
+static const char *const filter_outputs[] = { "out" };
+
+static void *
+filter_init(void)
+{
+    return tSVFInit(SVFTypeLowpass, 1000, 0.5f);
+}
+
+static int
+filter_set_mode(void *state, const char *mode)
+{
+    tSVF *svf = (tSVF *)state;
+
+    if(strcmp(mode, "lp") == 0)             svf->type = SVFTypeLowpass;
+    else if(strcmp(mode, "hp") == 0)        svf->type = SVFTypeHighpass;
+    else if(strcmp(mode, "bp") == 0)        svf->type = SVFTypeBandpass;
+    else if(strcmp(mode, "notch") == 0)     svf->type = SVFTypeNotch;
+    else if(strcmp(mode, "peak") == 0)      svf->type = SVFTypePeak;
+    else                                    return 1;
+
+    return 0;
+}
+
+static float
+filter_clip_freq(float f)
+{
+    return OOPS_clip(1.0f, f, 0.49f * OOPSGetSampleRate());
+}
+
+static void
+filter_process(void *state, parameter *params,
+        jack_default_audio_sample_t **values,
+        jack_default_audio_sample_t **outputs, jack_nframes_t nframes)
+{
+    tSVF *svf = (tSVF *)state;
+    jack_default_audio_sample_t *in = values[0], *out = outputs[0];
+    clis_segment segment;
+    jack_nframes_t i, n, freq_left = 0, res_left = 0;
+
+    // the coefficients are recomputed at the start of each parameters
+    // segments, the steps between control points are too fine to be worth it
+    for(i = 0; i < nframes; i += n) {
+        if(freq_left == 0) {
+            freq_left = clis_param_segment(&params[1], values[1], i, nframes,
+                    &segment);
+            tSVFSetFreq(svf, filter_clip_freq(segment.value));
+        }
+        if(res_left == 0) {
+            res_left = clis_param_segment(&params[2], values[2], i, nframes,
+                    &segment);
+            tSVFSetQ(svf, segment.value);
+        }
+
+        n = freq_left < res_left ? freq_left : res_left;
+
+        tSVFTickBlock(svf, in + i, NULL, NULL, out + i, n);
+
+        freq_left   -= n;
+        res_left    -= n;
+    }
+}
+
+/* noise: white or pink noise */
+
+static const char *const noise_outputs[] = { "out" };
+
+static void *
+noise_init(void)
+{
+    return tNoiseInit(WhiteNoise);
+}
+
+static int
+noise_set_mode(void *state, const char *mode)
+{
+    tNoise *noise = (tNoise *)state;
+
+    if(strcmp(mode, "white") == 0)          noise->type = WhiteNoise;
+    else if(strcmp(mode, "pink") == 0)      noise->type = PinkNoise;
+    else                                    return 1;
+
+    return 0;
+}
+
+static void
+noise_process(void *state, parameter *params,
+        jack_default_audio_sample_t **values,
+        jack_default_audio_sample_t **outputs, jack_nframes_t nframes)
+{
+    tNoise *noise = (tNoise *)state;
+
+    (void)params;
+    (void)values;
+
+    tNoiseTickBlock(noise, outputs[0], nframes);
+}
+
+/* midi: the pitch and gate of the notes held on a MIDI input, as voices */
+
+#define MIDI_VOICES     4
+#define MIDI_EVENTS     256     // events kept per block, the rest are dropped
+#define MIDI_NOTES      128
+
+// a decoded note event, time is the frame into the block it takes effect on
+typedef struct midi_event {
+    jack_nframes_t  time;
+    uint8_t         note;
+    uint8_t         velocity;   // 0 releases the note
+    bool            all_off;    // releases every note
+} midi_event;
+
+// the note events of one block, in the order they take effect
+typedef struct midi_queue {
+    size_t              length;
+    midi_event          events[MIDI_EVENTS];
+} midi_queue;
+
+typedef struct midi_state {
+    tPolyphonicHandler  *poly;
+    // the outputs of each voice, the pitch is held after the note is released
+    float               freq[MIDI_VOICES];
+    float               gate[MIDI_VOICES];
+    midi_queue          queue;
+} midi_state;
+
+static const char *const midi_outputs[] = {
+    "freq0", "gate0", "freq1", "gate1", "freq2", "gate2", "freq3", "gate3"
+};
+
+static void *
+midi_init(void)
+{
+    midi_state *midi = calloc(1, sizeof *midi);
+    size_t v;
+
+    if(midi == NULL)
+        return NULL;
+
+    midi->poly = tPolyphonicHandlerInit();
+    if(midi->poly == NULL) {
+        free(midi);
+        return NULL;
+    }
+
+    for(v = 0; v < MIDI_VOICES; v++) {
+        midi->freq[v] = OOPS_midiToFrequency(60) / FREQ_MOD_SCALE;
+    }
+
+    return midi;
+}
+
+/**
+ * Queue the note events of the block, note on with velocity 0 is a note off
+ * and all notes off and all sound off release every note. Everything else is
+ * ignored.
+ */
+static void
+read_events(midi_queue *queue, void *buffer, jack_nframes_t offset,
+            jack_nframes_t nframes)
+{
+    uint32_t i, length = jack_midi_get_event_count(buffer);
+    jack_midi_event_t event;
+    midi_event *out;
+    uint8_t type;
+
+    queue->length = 0;
+
+    for(i = 0; i < length; i++) {
+        if(jack_midi_event_get(&event, buffer, i) != 0 ||
+                event.time < offset || event.size < 3)
+            continue;
+        if(event.time >= offset + nframes || queue->length == MIDI_EVENTS)
+            break;
+
+        type    = event.buffer[0] & 0xf0;
+        out     = &queue->events[queue->length];
+        out->time       = event.time - offset;
+        out->note       = event.buffer[1] & 0x7f;
+        out->velocity   = 0;
+        out->all_off    = false;
+
+        if(type == 0x90) {
+            out->velocity = event.buffer[2] & 0x7f;
+        } else if(type == 0xb0 &&
+                (event.buffer[1] == 120 || event.buffer[1] == 123)) {
+            out->all_off = true;
+        } else if(type != 0x80) {
+            continue;
+        }
+
+        queue->length++;
+    }
+}
+
+static void
+midi_read(void *state, void *buffer, jack_nframes_t offset,
+          jack_nframes_t nframes)
+{
+    midi_state *midi = (midi_state *)state;
+
+    read_events(&midi->queue, buffer, offset, nframes);
+}
+
+// the handler assumes notes arrive paired, a note is released before it is
+// pressed again and only released while held
+static void
+midi_apply(midi_state *midi, const midi_event *event)
+{
+    tPolyphonicHandler *poly = midi->poly;
+    tMidiNote *note;
+    int n;
+    size_t v;
+
+    if(event->all_off) {
+        for(n = 0; n < MIDI_NOTES; n++) {
+            if(poly->midiNodes[n].midiNote.on)
+                tPolyphonicHandlerNoteOff(poly, n);
+        }
+    } else {
+        if(poly->midiNodes[event->note].midiNote.on)
+            tPolyphonicHandlerNoteOff(poly, event->note);
+        if(event->velocity > 0)
+            tPolyphonicHandlerNoteOn(poly, event->note, event->velocity);
+    }
+
+    // voice 0 plays the latest note held, voice 1 the one before and so on
+    for(v = 0; v < MIDI_VOICES; v++) {
+        note = tPolyphonicHandlerGetMidiNote(poly, (int8_t)v);
+
+        if(note == NULL) {
+            midi->gate[v] = 0;
+            continue;
+        }
+
+        midi->freq[v] = OOPS_midiToFrequency(note->pitch) / FREQ_MOD_SCALE;
+        midi->gate[v] = note->velocity / 127.0f;
+    }
+}
+
+static void
+midi_fill(midi_state *midi, jack_default_audio_sample_t **outputs,
+          jack_nframes_t from, jack_nframes_t to)
+{
+    jack_nframes_t i;
+    size_t v;
+
+    for(v = 0; v < MIDI_VOICES; v++) {
+        for(i = from; i < to; i++) {
+            outputs[v * 2][i]       = midi->freq[v];
+            outputs[v * 2 + 1][i]   = midi->gate[v];
+        }
+    }
+}
+
+static void
+midi_process(void *state, parameter *params,
+        jack_default_audio_sample_t **values,
+        jack_default_audio_sample_t **outputs, jack_nframes_t nframes)
+{
+    midi_state *midi = (midi_state *)state;
+    jack_nframes_t i = 0;
+    size_t e;
+
+    (void)params;
+    (void)values;
+
+    // every event takes effect on its own frame
+    for(e = 0; e < midi->queue.length; e++) {
+        midi_fill(midi, outputs, i, midi->queue.events[e].time);
+        midi_apply(midi, &midi->queue.events[e]);
+        i = midi->queue.events[e].time;
+    }
+
+    midi_fill(midi, outputs, i, nframes);
+}
+
+/* poly: a bank of wavetable voices played by a MIDI input, rendered a vector
+ * of voices at a time so a chord costs little more than a single osc */
+
+typedef struct poly_state {
+    clis_poly           bank;
+    midi_queue          queue;
+} poly_state;
+
+static const clis_param_def poly_params[] = {
+    { "amp",  'a', 1,   0, 1,        1,              0, CLIS_SMOOTH_NONE }
+};
+
+static const char *const poly_outputs[] = { "out" };
+
+static void *
+poly_init(void)
+{
+    // the voice arrays are aligned for the vector loads
+    poly_state *poly = aligned_alloc(_Alignof(poly_state), sizeof *poly);
+
+    if(poly == NULL)
+        return NULL;
+
+    clis_poly_init(&poly->bank, CLIS_POLY_SAW);
+    poly->queue.length = 0;
+
+    return poly;
+}
+
+// the waves of the voices, from the wavetables or drawn with PolyBLEP
+static const struct {
+    const char     *name;
+    clis_poly_wave  wave;
+    bool            blep;
+} poly_modes[] = {
+    { "saw",        CLIS_POLY_SAW, false },
+    { "sqr",        CLIS_POLY_SQR, false },
+    { "tri",        CLIS_POLY_TRI, false },
+    { "sin",        CLIS_POLY_SIN, false },
+    { "saw-blep",   CLIS_POLY_SAW, true },
+    { "sqr-blep",   CLIS_POLY_SQR, true },
+    { "tri-blep",   CLIS_POLY_TRI, true }
+};
+
+static int
+poly_set_mode(void *state, const char *mode)
+{
+    poly_state *poly = (poly_state *)state;
+    size_t i;
+
+    for(i = 0; i < LENGTH(poly_modes); i++) {
+        if(strcmp(mode, poly_modes[i].name) == 0) {
+            poly->bank.wave = poly_modes[i].wave;
+            poly->bank.blep = poly_modes[i].blep;
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+static void
+poly_read(void *state, void *buffer, jack_nframes_t offset,
+          jack_nframes_t nframes)
+{
+    poly_state *poly = (poly_state *)state;
+
+    read_events(&poly->queue, buffer, offset, nframes);
+}
+
+static void
+poly_apply(poly_state *poly, const midi_event *event)
+{
+    if(event->all_off)
+        clis_poly_all_off(&poly->bank);
+    else if(event->velocity > 0)
+        clis_poly_note_on(&poly->bank, event->note, event->velocity / 127.0f);
+    else
+        clis_poly_note_off(&poly->bank, event->note);
+}
+
+static void
+poly_process(void *state, parameter *params,
+        jack_default_audio_sample_t **values,
+        jack_default_audio_sample_t **outputs, jack_nframes_t nframes)
+{
+    poly_state *poly = (poly_state *)state;
+    jack_default_audio_sample_t *out = outputs[0], *amp = values[0];
+    jack_nframes_t i = 0, time;
+    size_t e;
+
+    (void)params;
+
+    // every event takes effect on its own frame
+    for(e = 0; e < poly->queue.length; e++) {
+        time = poly->queue.events[e].time;
+        clis_poly_render(&poly->bank, out + i, time - i);
+        poly_apply(poly, &poly->queue.events[e]);
+        i = time;
+    }
+
+    clis_poly_render(&poly->bank, out + i, nframes - i);
+
+    for(i = 0; i < nframes; i++) {
+        out[i] *= amp[i];
+    }
+}
+
+static const clis_gen gens[] = {
+    { "osc",    LENGTH(osc_params), osc_params,
+        LENGTH(osc_outputs), osc_outputs, 0,
+        osc_init, NULL, osc_set_mode, osc_process, NULL },
+    { "lfo",    LENGTH(lfo_params), lfo_params,
+        LENGTH(lfo_outputs), lfo_outputs, 0,
+        lfo_init, NULL, NULL, lfo_process, NULL },
+    { "filter", LENGTH(filter_params), filter_params,
+        LENGTH(filter_outputs), filter_outputs, 0,
+        filter_init, NULL, filter_set_mode, filter_process, NULL },
+    { "noise",  0, NULL,
+        LENGTH(noise_outputs), noise_outputs, 0,
+        noise_init, NULL, noise_set_mode, noise_process, NULL },
+    { "midi",   0, NULL,
+        LENGTH(midi_outputs), midi_outputs, 0,
+        midi_init, free, NULL, midi_process, midi_read },
+    { "poly",   LENGTH(poly_params), poly_params,
+        LENGTH(poly_outputs), poly_outputs, 0,
+        poly_init, free, poly_set_mode, poly_process, poly_read },
+};
+
+/**
+ * @param name - a generator name such as 'osc'
+ * @return the generator or NULL if there is no generator called name
+ */
+const clis_gen *
+clis_gen_find(const char *name)
+{
+    size_t i;
+
+    for(i = 0; i < LENGTH(gens); i++) {
+        if(strcmp(gens[i].name, name) == 0)
+            return &gens[i];
+    }
+
+    return NULL;
+}
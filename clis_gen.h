@@ -0,0 +1,62 @@
+#ifndef CLIS_GEN_INC
+#define CLIS_GEN_INC
+
+#include <stddef.h>
+#include <jack/jack.h>
+
+#include "clis.h"
+
+#define CLIS_GEN_MAX_PARAMS     8
+#define CLIS_GEN_MAX_OUTPUTS    8
+
+/**
+ *  Renders one block of a generator.
+ *
+ *  @param state - the instance returned by the generators init
+ *  @param params - the instances parameters, in the order of the definitions
+ *  @param values - the value of each parameter for every frame of the block,
+ *  modulated and clamped to its range by clis_eval_params
+ *  @param outputs - one buffer per generator output
+ *  @param nframes - the block length
+ */
+typedef void (*clis_gen_process)(void *state, parameter *params,
+        jack_default_audio_sample_t **values,
+        jack_default_audio_sample_t **outputs, jack_nframes_t nframes);
+
+/**
+ *  Reads the MIDI events of one block of a generator. Called just before the
+ *  generators process with the same block, the generator keeps the events of
+ *  the block to apply them on their frames as it renders it.
+ *
+ *  @param state - the instance returned by the generators init
+ *  @param buffer - the JACK MIDI buffer of the instances 'midi' input for the
+ *  whole period, event times are frames into the period
+ *  @param offset - the first frame of the block in the period
+ *  @param nframes - the block length
+ */
+typedef void (*clis_gen_midi)(void *state, void *buffer,
+        jack_nframes_t offset, jack_nframes_t nframes);
+
+// a generator type that can be instantiated by name, eg. 'osc'
+typedef struct clis_gen {
+    const char              *name;
+    size_t                  params_length;
+    const clis_param_def    *params;    // one definition per parameter
+    size_t                  outputs_length;
+    const char *const       *outputs;
+    // frames the outputs lag the parameters, reported to JACK
+    jack_nframes_t          latency;
+    // returns a new instance or NULL if OOPS has no more components
+    void                    *(*init)(void);
+    // optional, frees an instance. OOPS components are never freed
+    void                    (*free)(void *state);
+    // optional, selects a mode such as a filter response. returns 0 on success
+    int                     (*set_mode)(void *state, const char *mode);
+    clis_gen_process        process;
+    // optional, gives instances a JACK MIDI input port named 'name.midi'
+    clis_gen_midi           midi;
+} clis_gen;
+
+const clis_gen  *clis_gen_find(const char *name);
+
+#endif // CLIS_GEN_INC
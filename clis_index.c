@@ -0,0 +1,268 @@
+#include <stdlib.h>
+#include <string.h>
+#include <jack/jack.h>
+
+#include "clis.h"
+#include "clis_index.h"
+
+/**
+ * 32 bit FNV-1a hash of a port name.
+ */
+static uint32_t
+hash_name(const char *name)
+{
+    uint32_t hash = 2166136261u;
+
+    while(*name) {
+        hash ^= (unsigned char)*name++;
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+/**
+ * Scramble a port id so that the sequential ids JACK hands out spread over the
+ * id table.
+ */
+static size_t
+hash_port_id(jack_port_id_t port_id)
+{
+    return (size_t)(port_id * 2654435761u);
+}
+
+/**
+ * Round up to the next power of two, the tables are indexed with a mask.
+ */
+static size_t
+next_pow2(size_t n)
+{
+    size_t size = 1;
+
+    while(size < n)
+        size <<= 1;
+
+    return size;
+}
+
+static clis_index_entry *
+find_name(clis_index *index, const char *name, uint32_t hash)
+{
+    clis_index_entry *entry = index->by_name[hash & index->name_mask];
+
+    for(; entry != NULL; entry = entry->next) {
+        if(entry->hash == hash && strcmp(entry->name, name) == 0)
+            return entry;
+    }
+
+    return NULL;
+}
+
+/**
+ * Build the index of every mod source name used by the parameters. Sources
+ * with the same name share one entry so each port event touches one entry no
+ * matter how many parameters follow that port.
+ *
+ * The index stores indices into params so the parameters and their mod
+ * sources must not be reallocated after this is called.
+ *
+ * @param index - the index to build, any previous contents are not freed
+ * @param params - the parameters to index
+ * @param params_length - the number of parameters
+ * @return 0 on success or -1 if allocation failed, the index is left empty
+ */
+int
+clis_index_build(clis_index *index, struct parameter *params,
+                 size_t params_length)
+{
+    size_t i, j, total = 0;
+    clis_subscriber *subscribers;
+    clis_index_entry *entry;
+
+    memset(index, 0, sizeof *index);
+
+    // sources rendered in this process never become JACK ports
+    for(i = 0; i < params_length; i++) {
+        for(j = 0; j < params[i].mods.length; j++) {
+            if(params[i].mods.sources[j].local == NULL)
+                total++;
+        }
+    }
+
+    if(total == 0)
+        return 0;
+
+    index->name_mask = next_pow2(total * 2) - 1;
+    index->id_mask   = next_pow2(total * 2) - 1;
+    index->entries   = calloc(total, sizeof *index->entries);
+    index->by_name   = calloc(index->name_mask + 1, sizeof *index->by_name);
+    index->by_id     = calloc(index->id_mask + 1, sizeof *index->by_id);
+    subscribers      = calloc(total, sizeof *subscribers);
+
+    if(index->entries == NULL || index->by_name == NULL ||
+            index->by_id == NULL || subscribers == NULL) {
+        free(subscribers);
+        clis_index_free(index);
+        return -1;
+    }
+
+    // intern the names and count the subscribers of each one
+    for(i = 0; i < params_length; i++) {
+        for(j = 0; j < params[i].mods.length; j++) {
+            const char *name = params[i].mods.sources[j].name;
+            uint32_t hash;
+
+            if(params[i].mods.sources[j].local != NULL)
+                continue;
+
+            hash = hash_name(name);
+            entry = find_name(index, name, hash);
+            if(entry == NULL) {
+                entry               = &index->entries[index->length++];
+                entry->name         = name;
+                entry->hash         = hash;
+                entry->next         = index->by_name[hash & index->name_mask];
+                index->by_name[hash & index->name_mask] = entry;
+            }
+            entry->subscribers_length++;
+        }
+    }
+
+    // hand out slices of the one subscriber block, the first entry owns it
+    for(i = 0; i < index->length; i++) {
+        entry               = &index->entries[i];
+        entry->subscribers  = subscribers;
+        subscribers        += entry->subscribers_length;
+        entry->subscribers_length = 0;
+    }
+
+    for(i = 0; i < params_length; i++) {
+        for(j = 0; j < params[i].mods.length; j++) {
+            const char *name = params[i].mods.sources[j].name;
+
+            if(params[i].mods.sources[j].local != NULL)
+                continue;
+
+            entry = find_name(index, name, hash_name(name));
+            entry->subscribers[entry->subscribers_length].param  = i;
+            entry->subscribers[entry->subscribers_length].source = j;
+            entry->subscribers_length++;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @return the entry for a full JACK port name or NULL if nothing subscribes
+ *  to it
+ */
+clis_index_entry *
+clis_index_find_name(clis_index *index, const char *name)
+{
+    if(index->length == 0)
+        return NULL;
+
+    return find_name(index, name, hash_name(name));
+}
+
+/**
+ * @return the entry bound to a JACK port id or NULL if the port is not one
+ *  any parameter subscribes to
+ */
+clis_index_entry *
+clis_index_find_port(clis_index *index, jack_port_id_t port_id)
+{
+    size_t slot;
+    clis_index_entry *entry;
+
+    if(index->length == 0)
+        return NULL;
+
+    slot = hash_port_id(port_id) & index->id_mask;
+    while((entry = index->by_id[slot]) != NULL) {
+        if(entry->port_id == port_id)
+            return entry;
+        slot = (slot + 1) & index->id_mask;
+    }
+
+    return NULL;
+}
+
+/**
+ * Record the JACK port id an entry currently resolves to. The id table has
+ * room for every entry so this never allocates.
+ */
+void
+clis_index_bind(clis_index *index, clis_index_entry *entry,
+                jack_port_id_t port_id)
+{
+    size_t slot;
+
+    if(entry->bound)
+        clis_index_unbind(index, entry);
+
+    entry->bound    = 1;
+    entry->port_id  = port_id;
+
+    slot = hash_port_id(port_id) & index->id_mask;
+    while(index->by_id[slot] != NULL) {
+        slot = (slot + 1) & index->id_mask;
+    }
+    index->by_id[slot] = entry;
+}
+
+/**
+ * Forget the port id of an entry. Uses backward shift deletion so the probe
+ * chains stay intact without tombstones.
+ */
+void
+clis_index_unbind(clis_index *index, clis_index_entry *entry)
+{
+    size_t slot, next, home;
+
+    if(!entry->bound)
+        return;
+
+    entry->bound = 0;
+
+    slot = hash_port_id(entry->port_id) & index->id_mask;
+    while(index->by_id[slot] != entry) {
+        slot = (slot + 1) & index->id_mask;
+    }
+
+    next = slot;
+    for(;;) {
+        index->by_id[slot] = NULL;
+
+        // pull later members of the chain back over the hole
+        do {
+            next = (next + 1) & index->id_mask;
+            if(index->by_id[next] == NULL)
+                return;
+            home = hash_port_id(index->by_id[next]->port_id) & index->id_mask;
+        } while(slot <= next
+                ? (slot < home && home <= next)
+                : (slot < home || home <= next));
+
+        index->by_id[slot] = index->by_id[next];
+        slot = next;
+    }
+}
+
+/**
+ * Free the index tables, the interned names belong to the mod sources and are
+ * not freed.
+ */
+void
+clis_index_free(clis_index *index)
+{
+    if(index->entries != NULL && index->length > 0)
+        free(index->entries[0].subscribers);
+
+    free(index->entries);
+    free(index->by_name);
+    free(index->by_id);
+
+    memset(index, 0, sizeof *index);
+}
@@ -0,0 +1,52 @@
+#ifndef CLIS_INDEX_INC
+#define CLIS_INDEX_INC
+
+#include <stddef.h>
+#include <stdint.h>
+#include <jack/jack.h>
+
+struct parameter;
+
+// a mod source that follows a JACK port, stored as indices into the contexts
+// parameters and the parameters mod sources
+typedef struct clis_subscriber {
+    size_t param;
+    size_t source;
+} clis_subscriber;
+
+// one entry per distinct port name any parameter is modulated by
+typedef struct clis_index_entry {
+    const char      *name;          // interned, owned by the first mod source
+    uint32_t        hash;
+    int             bound;          // the port exists and port_id is valid
+    int             connect;        // bound, the subscribers need connecting
+    jack_port_id_t  port_id;
+    size_t          subscribers_length;
+    clis_subscriber *subscribers;
+    struct clis_index_entry *next;  // next entry in the same name bucket
+} clis_index_entry;
+
+typedef struct clis_index {
+    size_t           length;
+    clis_index_entry *entries;
+    // chained hash table on the port name, power of two buckets
+    size_t           name_mask;
+    clis_index_entry **by_name;
+    // open addressed hash table on the JACK port id of bound entries
+    size_t           id_mask;
+    clis_index_entry **by_id;
+} clis_index;
+
+int                 clis_index_build(clis_index *index,
+                                     struct parameter *params,
+                                     size_t params_length);
+clis_index_entry   *clis_index_find_name(clis_index *index, const char *name);
+clis_index_entry   *clis_index_find_port(clis_index *index,
+                                         jack_port_id_t port_id);
+void                clis_index_bind(clis_index *index, clis_index_entry *entry,
+                                    jack_port_id_t port_id);
+void                clis_index_unbind(clis_index *index,
+                                      clis_index_entry *entry);
+void                clis_index_free(clis_index *index);
+
+#endif // CLIS_INDEX_INC
@@ -0,0 +1,649 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <jack/jack.h>
+
+#include "clis.h"
+#include "clis_gen.h"
+#include "clis_patch.h"
+
+#define PATCH_DELIM     " \t\r\n"
+#define DEFAULT_OUTPUT  "output"
+
+/**
+ * @return the index of the node called name or -1 if there is none
+ */
+static long
+find_node(clis_patch *patch, const char *name, size_t name_length)
+{
+    size_t i;
+
+    for(i = 0; i < patch->nodes_length; i++) {
+        if(strlen(patch->nodes[i].name) == name_length &&
+                strncmp(patch->nodes[i].name, name, name_length) == 0)
+            return (long)i;
+    }
+
+    return -1;
+}
+
+/**
+ * Grow the node and parameter arrays for a new node of type gen.
+ *
+ * @return the new node with its parameters set to the generators defaults or
+ *  NULL if allocation failed
+ */
+static clis_node *
+add_node(clis_patch *patch, const clis_gen *gen)
+{
+    clis_node *nodes;
+    parameter *params;
+    clis_node *node;
+    size_t i;
+
+    nodes = realloc(patch->nodes, (patch->nodes_length + 1) * sizeof *nodes);
+    if(nodes == NULL)
+        return NULL;
+    patch->nodes = nodes;
+
+    params = realloc(patch->params,
+            (patch->params_length + gen->params_length) * sizeof *params);
+    if(params == NULL && gen->params_length > 0)
+        return NULL;
+    patch->params = params;
+
+    node = &patch->nodes[patch->nodes_length++];
+    memset(node, 0, sizeof *node);
+    node->gen               = gen;
+    node->params_offset     = patch->params_length;
+    node->outputs_offset    = patch->outputs_length;
+
+    for(i = 0; i < gen->params_length; i++) {
+        clis_param_init(&patch->params[patch->params_length++],
+                &gen->params[i]);
+    }
+    patch->outputs_length += gen->outputs_length;
+
+    return node;
+}
+
+/**
+ * Add a generator to the patch from a spec string in the format:
+ *
+ *   gen name [-p] [-m mode] [-<param> value]...
+ *
+ * eg. 'osc osc1 -f 300 -f lfo:saw:2000 -p'. Parameters take the same values
+ * as the main program, a source naming a node in this patch is read from that
+ * node directly instead of through JACK.
+ *
+ * @param patch - the patch to add to
+ * @param spec - the generator spec, this is tokenised in place
+ * @return CLIS_OK or an error code according to clis_rc
+ */
+clis_rc
+clis_patch_add(clis_patch *patch, char *spec)
+{
+    char *save = NULL, *token, *arg;
+    const char *type, *name;
+    const clis_gen *gen;
+    clis_node *node;
+    parameter *params;
+    size_t i;
+    clis_rc rc;
+
+    type = strtok_r(spec, PATCH_DELIM, &save);
+    name = strtok_r(NULL, PATCH_DELIM, &save);
+
+    if(type == NULL || name == NULL || name[0] == '-' || strchr(name, ':'))
+        return CLIS_E_PATCH_SYNTAX;
+
+    if(find_node(patch, name, strlen(name)) >= 0)
+        return CLIS_E_NAME_TAKEN;
+
+    gen = clis_gen_find(type);
+    if(gen == NULL)
+        return CLIS_E_UNKNOWN_GEN;
+
+    node = add_node(patch, gen);
+    if(node == NULL)
+        return CLIS_E_ALLOC_NODE;
+
+    node->name = strdup(name);
+    if(node->name == NULL)
+        return CLIS_E_ALLOC_NODE;
+
+    params = &patch->params[node->params_offset];
+
+    while((token = strtok_r(NULL, PATCH_DELIM, &save)) != NULL) {
+        if(token[0] != '-' || token[1] == '\0' || token[2] != '\0')
+            return CLIS_E_PATCH_SYNTAX;
+
+        if(token[1] == 'p') {
+            node->play = true;
+            continue;
+        }
+
+        arg = strtok_r(NULL, PATCH_DELIM, &save);
+        if(arg == NULL)
+            return CLIS_E_PATCH_SYNTAX;
+
+        if(token[1] == 'm') {
+            free(node->mode);
+            node->mode = strdup(arg);
+            if(node->mode == NULL)
+                return CLIS_E_ALLOC_NODE;
+            continue;
+        }
+
+        for(i = 0; i < gen->params_length; i++) {
+            if(gen->params[i].opt == token[1])
+                break;
+        }
+        if(i == gen->params_length)
+            return CLIS_E_PATCH_SYNTAX;
+
+        rc = clis_parse_param_string(arg, &params[i]);
+        if(rc)
+            return rc;
+    }
+
+    return CLIS_OK;
+}
+
+/**
+ * Add every generator in a patch file, one spec per line. Blank lines and
+ * anything after a '#' are ignored.
+ *
+ * @param patch - the patch to add to
+ * @param path - the patch file
+ * @return CLIS_OK or an error code according to clis_rc, the failing line is
+ *  reported on stderr
+ */
+clis_rc
+clis_patch_load(clis_patch *patch, const char *path)
+{
+    FILE *file = fopen(path, "r");
+    char *line = NULL, *comment;
+    size_t size = 0;
+    unsigned int number = 0;
+    clis_rc rc = CLIS_OK;
+
+    if(file == NULL) {
+        perror(path);
+        return CLIS_E_PATCH_SYNTAX;
+    }
+
+    while(getline(&line, &size, file) != -1) {
+        number++;
+
+        if((comment = strchr(line, '#')) != NULL)
+            *comment = '\0';
+
+        if(strspn(line, PATCH_DELIM) == strlen(line))
+            continue;
+
+        rc = clis_patch_add(patch, line);
+        if(rc) {
+            fprintf(stderr, "%s:%u: ", path, number);
+            break;
+        }
+    }
+
+    free(line);
+    fclose(file);
+
+    return rc;
+}
+
+/**
+ * Render one node, run by the scheduler once every source it reads from has
+ * been rendered this period.
+ */
+static void
+run_node(void *arg, size_t index, jack_nframes_t offset,
+         jack_nframes_t nframes)
+{
+    clis_patch *patch   = (clis_patch *)arg;
+    clis_node *node     = &patch->nodes[index];
+    parameter *params   = &patch->params[node->params_offset];
+    jack_default_audio_sample_t *values[CLIS_GEN_MAX_PARAMS];
+    jack_default_audio_sample_t *outputs[CLIS_GEN_MAX_OUTPUTS];
+    size_t i;
+
+    clis_eval_params(params, node->gen->params_length, offset, nframes,
+            values);
+
+    for(i = 0; i < node->gen->outputs_length; i++) {
+        outputs[i] = patch->outputs[node->outputs_offset + i] + offset;
+    }
+
+    if(node->midi_port != NULL)
+        node->gen->midi(node->state, node->midi_buffer, offset, nframes);
+
+    node->gen->process(node->state, params, values, outputs, nframes);
+}
+
+// renders a sub-block of the period between two control events
+static void
+render_block(void *arg, jack_nframes_t offset, jack_nframes_t nframes)
+{
+    clis_patch *patch = (clis_patch *)arg;
+
+    clis_sched_run(&patch->sched, offset, nframes);
+}
+
+/**
+ * Point every mod source that names a node of this patch at that nodes output
+ * buffer and schedule the nodes so every source is rendered before it is read.
+ * Sources may be declared in any order but may not modulate themselves, either
+ * directly or through other nodes.
+ *
+ * Must be called once after the last node is added.
+ *
+ * @return CLIS_OK or an error code according to clis_rc
+ */
+clis_rc
+clis_patch_link(clis_patch *patch)
+{
+    size_t i, j, k, n;
+    size_t (*edges)[2] = NULL, edges_length = 0, edges_size = 0;
+    clis_rc rc = CLIS_OK;
+
+    patch->ports    = calloc(patch->outputs_length, sizeof *patch->ports);
+    patch->outputs  = calloc(patch->outputs_length, sizeof *patch->outputs);
+    if(patch->outputs_length > 0 && (!patch->ports || !patch->outputs))
+        return CLIS_E_ALLOC_NODE;
+
+    patch->names = calloc(patch->params_length, sizeof *patch->names);
+    if(patch->params_length > 0 && patch->names == NULL)
+        return CLIS_E_ALLOC_NODE;
+
+    for(n = 0; n < patch->nodes_length; n++) {
+        clis_node *node = &patch->nodes[n];
+
+        for(i = 0; i < node->gen->params_length; i++) {
+            char **name = &patch->names[node->params_offset + i];
+
+            *name = malloc(strlen(node->name) +
+                    strlen(node->gen->params[i].name) + 2);
+            if(*name == NULL)
+                return CLIS_E_ALLOC_NODE;
+            sprintf(*name, "%s.%s", node->name, node->gen->params[i].name);
+        }
+    }
+
+    for(i = 0; i < patch->params_length; i++) {
+        edges_size += patch->params[i].mods.length;
+    }
+    if(edges_size > 0) {
+        edges = calloc(edges_size, sizeof *edges);
+        if(edges == NULL)
+            return CLIS_E_ALLOC_NODE;
+    }
+
+    for(n = 0; n < patch->nodes_length; n++) {
+        clis_node *node = &patch->nodes[n];
+
+        for(i = 0; i < node->gen->params_length; i++) {
+            parameter *param = &patch->params[node->params_offset + i];
+
+            for(j = 0; j < param->mods.length; j++) {
+                mod_source *source  = &param->mods.sources[j];
+                const char *port    = strchr(source->name, ':');
+                long src            = port == NULL ? -1
+                    : find_node(patch, source->name,
+                                (size_t)(port - source->name));
+                clis_node *from;
+
+                // not ours, resolved against the JACK graph by clis_start
+                if(port == NULL || src < 0)
+                    continue;
+
+                from = &patch->nodes[src];
+                port++;
+
+                if(strcmp(port, DEFAULT_OUTPUT) == 0) {
+                    k = 0;
+                } else {
+                    for(k = 0; k < from->gen->outputs_length; k++) {
+                        if(strcmp(from->gen->outputs[k], port) == 0)
+                            break;
+                    }
+                    if(k == from->gen->outputs_length) {
+                        rc = CLIS_E_UNKNOWN_OUTPUT;
+                        goto out;
+                    }
+                }
+
+                source->local = &patch->outputs[from->outputs_offset + k];
+                edges[edges_length][0] = (size_t)src;
+                edges[edges_length][1] = n;
+                edges_length++;
+            }
+        }
+    }
+
+    switch(clis_sched_compile(&patch->sched, patch->nodes_length,
+                (const size_t (*)[2])edges, edges_length, run_node, patch)) {
+        case 0:     rc = CLIS_OK;               break;
+        case -2:    rc = CLIS_E_NODE_CYCLE;     break;
+        default:    rc = CLIS_E_ALLOC_NODE;     break;
+    }
+
+out:
+    free(edges);
+
+    return rc;
+}
+
+/**
+ * Create the OOPS components of every node and register a JACK output port
+ * for every node output, named 'node.output', and a MIDI input port named
+ * 'node.midi' for nodes that take MIDI. OOPS must be initialised first.
+ *
+ * @return CLIS_OK or an error code according to clis_rc
+ */
+clis_rc
+clis_patch_instantiate(clis_patch *patch, jack_client_t *client)
+{
+    char port_name[64];
+    size_t n, k;
+
+    for(n = 0; n < patch->nodes_length; n++) {
+        clis_node *node = &patch->nodes[n];
+
+        node->state = node->gen->init();
+        if(node->state == NULL)
+            return CLIS_E_ALLOC_NODE;
+
+        if(node->mode != NULL && (node->gen->set_mode == NULL ||
+                    node->gen->set_mode(node->state, node->mode) != 0))
+            return CLIS_E_PATCH_SYNTAX;
+
+        for(k = 0; k < node->gen->outputs_length; k++) {
+            jack_port_t **port = &patch->ports[node->outputs_offset + k];
+
+            snprintf(port_name, sizeof port_name, "%s.%s", node->name,
+                    node->gen->outputs[k]);
+            *port = jack_port_register(client, port_name,
+                    JACK_DEFAULT_AUDIO_TYPE, JackPortIsOutput, 0);
+            if(*port == NULL)
+                return CLIS_E_REGISTER_PORT;
+        }
+
+        if(node->gen->midi != NULL) {
+            snprintf(port_name, sizeof port_name, "%s.midi", node->name);
+            node->midi_port = jack_port_register(client, port_name,
+                    JACK_DEFAULT_MIDI_TYPE, JackPortIsInput, 0);
+            if(node->midi_port == NULL)
+                return CLIS_E_REGISTER_PORT;
+        }
+    }
+
+    return CLIS_OK;
+}
+
+/**
+ * Connect the first output of every node marked with -p to the hardware. The
+ * client must be active.
+ */
+clis_rc
+clis_patch_play(clis_patch *patch, jack_client_t *client)
+{
+    size_t n;
+    clis_rc rc;
+
+    for(n = 0; n < patch->nodes_length; n++) {
+        clis_node *node = &patch->nodes[n];
+        jack_port_t *port;
+
+        if(!node->play || node->gen->outputs_length == 0)
+            continue;
+
+        port = patch->ports[node->outputs_offset];
+        rc = clis_play_audio(client, port, port);
+        if(rc)
+            return rc;
+    }
+
+    return CLIS_OK;
+}
+
+/**
+ * Start the threads that render the patch. Must be called before the client is
+ * activated.
+ *
+ * @param workers_length - the number of threads that render each period,
+ *  including the JACK process thread. 1 renders every node in order on the
+ *  JACK thread.
+ * @return CLIS_OK or an error code according to clis_rc
+ */
+clis_rc
+clis_patch_start(clis_patch *patch, jack_client_t *client,
+                 size_t workers_length)
+{
+    if(clis_sched_start(&patch->sched, client, workers_length) != 0)
+        return CLIS_E_START_WORKERS;
+
+    return CLIS_OK;
+}
+
+/**
+ * JACK process callback for a patch, renders every node straight into the
+ * JACK output buffers. Nodes that do not depend on each other are rendered in
+ * parallel when the patch was started with more than one worker. The period is
+ * split into sub-blocks at each control event.
+ */
+int
+clis_patch_process(jack_nframes_t nframes, void *arg)
+{
+    clis_patch *patch = (clis_patch *)arg;
+    size_t i;
+
+    for(i = 0; i < patch->outputs_length; i++) {
+        patch->outputs[i] = (jack_default_audio_sample_t *)
+            jack_port_get_buffer(patch->ports[i], nframes);
+    }
+
+    for(i = 0; i < patch->nodes_length; i++) {
+        clis_node *node = &patch->nodes[i];
+
+        if(node->midi_port != NULL)
+            node->midi_buffer = jack_port_get_buffer(node->midi_port, nframes);
+    }
+
+    clis_control_process(&patch->control, nframes, render_block, patch);
+
+    return 0;
+}
+
+/**
+ * @return the node that renders the output local points at
+ */
+static clis_node *
+output_node(clis_patch *patch, jack_default_audio_sample_t **local)
+{
+    size_t index = (size_t)(local - patch->outputs), n = 0;
+
+    // nodes own consecutive slices of the outputs in the order they were added
+    while(n + 1 < patch->nodes_length &&
+            patch->nodes[n + 1].outputs_offset <= index)
+        n++;
+
+    return &patch->nodes[n];
+}
+
+/**
+ * Walk the nodes in the order they render, each nodes outputs lag the latest
+ * of its sources, inside or outside the patch, by the latency of its
+ * generator.
+ */
+static void
+capture_latency(clis_patch *patch)
+{
+    jack_latency_range_t range;
+    parameter *param;
+    mod_source *source;
+    clis_node *node;
+    size_t k, i, j;
+    bool any;
+
+    for(k = 0; k < patch->nodes_length; k++) {
+        node    = &patch->nodes[patch->sched.order[k]];
+        any     = false;
+
+        for(i = 0; i < node->gen->params_length; i++) {
+            param = &patch->params[node->params_offset + i];
+
+            for(j = 0; j < param->mods.length; j++) {
+                source = &param->mods.sources[j];
+
+                if(source->local != NULL)
+                    clis_latency_widen(&range, &any,
+                            output_node(patch, source->local)->latency);
+                else if(source->input != NULL)
+                    clis_latency_merge(&range, &any, source->input,
+                            JackCaptureLatency);
+            }
+        }
+        if(node->midi_port != NULL)
+            clis_latency_merge(&range, &any, node->midi_port,
+                    JackCaptureLatency);
+
+        if(!any)
+            range.min = range.max = 0;
+        node->latency.min = range.min + node->gen->latency;
+        node->latency.max = range.max + node->gen->latency;
+        node->latency_any = true;
+
+        for(i = 0; i < node->gen->outputs_length; i++) {
+            clis_latency_apply(patch->ports[node->outputs_offset + i],
+                    JackCaptureLatency, range, any, node->gen->latency);
+        }
+    }
+}
+
+/**
+ * Walk the nodes in reverse, each nodes sources are due the generators
+ * latency before the earliest of its consumers, inside or outside the patch.
+ */
+static void
+playback_latency(clis_patch *patch)
+{
+    jack_latency_range_t range;
+    parameter *param;
+    clis_task *task;
+    clis_node *node;
+    size_t k, i, j;
+    bool any;
+
+    for(k = patch->nodes_length; k-- > 0;) {
+        node    = &patch->nodes[patch->sched.order[k]];
+        task    = &patch->sched.tasks[patch->sched.order[k]];
+        any     = false;
+
+        for(i = 0; i < node->gen->outputs_length; i++) {
+            clis_latency_merge(&range, &any,
+                    patch->ports[node->outputs_offset + i],
+                    JackPlaybackLatency);
+        }
+        // consumers that feed nothing are not on the way to any playback
+        for(i = 0; i < task->succ_length; i++) {
+            if(patch->nodes[task->succ[i]].latency_any)
+                clis_latency_widen(&range, &any,
+                        patch->nodes[task->succ[i]].latency);
+        }
+
+        if(!any)
+            range.min = range.max = 0;
+        node->latency.min = range.min + node->gen->latency;
+        node->latency.max = range.max + node->gen->latency;
+        node->latency_any = any;
+
+        for(i = 0; i < node->gen->params_length; i++) {
+            param = &patch->params[node->params_offset + i];
+
+            for(j = 0; j < param->mods.length; j++) {
+                if(param->mods.sources[j].input != NULL)
+                    jack_port_set_latency_range(param->mods.sources[j].input,
+                            JackPlaybackLatency, &node->latency);
+            }
+        }
+        if(node->midi_port != NULL)
+            jack_port_set_latency_range(node->midi_port,
+                    JackPlaybackLatency, &node->latency);
+    }
+}
+
+/**
+ * JACK latency callback for a patch. Latency is tracked through the patch
+ * node by node, so a source that reaches an output through a generator with
+ * latency is reported later than one that does not.
+ */
+void
+clis_patch_latency(jack_latency_callback_mode_t mode, void *arg)
+{
+    clis_patch *patch = (clis_patch *)arg;
+
+    if(mode == JackCaptureLatency)
+        capture_latency(patch);
+    else
+        playback_latency(patch);
+}
+
+/**
+ * Print the mean and worst render time of every node.
+ */
+void
+clis_patch_report(clis_patch *patch, FILE *file)
+{
+    size_t n;
+
+    fprintf(file, "%-16s %10s %10s %10s\n", "node", "runs", "mean us",
+            "max us");
+
+    for(n = 0; n < patch->nodes_length; n++) {
+        clis_task *task = &patch->sched.tasks[n];
+        uint64_t runs   = atomic_load(&task->runs);
+        double mean     = runs ? (double)atomic_load(&task->total_ns) / runs
+                               : 0.0;
+
+        fprintf(file, "%-16s %10llu %10.2f %10.2f\n", patch->nodes[n].name,
+                (unsigned long long)runs, mean / 1000.0,
+                (double)atomic_load(&task->max_ns) / 1000.0);
+    }
+}
+
+/**
+ * Free the nodes and the patch arrays. The parameters mod sources are owned by
+ * the clis_context they are handed to and are freed by clis_close.
+ */
+void
+clis_patch_free(clis_patch *patch)
+{
+    size_t n;
+
+    clis_control_stop(&patch->control);
+
+    for(n = 0; n < patch->nodes_length; n++) {
+        clis_node *node = &patch->nodes[n];
+
+        if(node->state != NULL && node->gen->free != NULL)
+            node->gen->free(node->state);
+        free(node->name);
+        free(node->mode);
+    }
+
+    for(n = 0; patch->names != NULL && n < patch->params_length; n++) {
+        free(patch->names[n]);
+    }
+
+    free(patch->nodes);
+    free(patch->params);
+    free(patch->names);
+    free(patch->ports);
+    free(patch->outputs);
+    clis_sched_free(&patch->sched);
+
+    memset(patch, 0, sizeof *patch);
+}
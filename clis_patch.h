@@ -0,0 +1,63 @@
+#ifndef CLIS_PATCH_INC
+#define CLIS_PATCH_INC
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <jack/jack.h>
+
+#include "clis.h"
+#include "clis_control.h"
+#include "clis_gen.h"
+#include "clis_sched.h"
+
+// one generator instance inside the host
+typedef struct clis_node {
+    const clis_gen  *gen;
+    char            *name;
+    void            *state;
+    bool            play;
+    char            *mode;
+    // offsets of the nodes slices of the patch parameter and output arrays
+    size_t          params_offset;
+    size_t          outputs_offset;
+    // the MIDI input of generators that take one, and its current buffer
+    jack_port_t     *midi_port;
+    void            *midi_buffer;
+    // the latency at the nodes outputs, or inputs in playback mode, while
+    // clis_patch_latency walks the patch
+    jack_latency_range_t latency;
+    bool            latency_any;    // false if nothing downstream of the node
+} clis_node;
+
+// every generator running in one JACK client
+typedef struct clis_patch {
+    size_t          nodes_length;
+    clis_node       *nodes;
+    size_t          params_length;
+    parameter       *params;
+    char            **names;        // 'node.param' for each parameter
+    size_t          outputs_length;
+    jack_port_t     **ports;
+    // the buffer of every output for the current cycle. Nodes read each others
+    // outputs straight from here so nothing is copied inside the patch.
+    jack_default_audio_sample_t **outputs;
+    // the order nodes are rendered in, built from the local mod sources
+    clis_sched      sched;
+    // live parameter changes, applied at the start of each period
+    clis_control    control;
+} clis_patch;
+
+clis_rc clis_patch_add(clis_patch *patch, char *spec);
+clis_rc clis_patch_load(clis_patch *patch, const char *path);
+clis_rc clis_patch_link(clis_patch *patch);
+clis_rc clis_patch_instantiate(clis_patch *patch, jack_client_t *client);
+clis_rc clis_patch_play(clis_patch *patch, jack_client_t *client);
+clis_rc clis_patch_start(clis_patch *patch, jack_client_t *client,
+                         size_t workers_length);
+int     clis_patch_process(jack_nframes_t nframes, void *arg);
+void    clis_patch_latency(jack_latency_callback_mode_t mode, void *arg);
+void    clis_patch_report(clis_patch *patch, FILE *file);
+void    clis_patch_free(clis_patch *patch);
+
+#endif // CLIS_PATCH_INC
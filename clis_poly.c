@@ -0,0 +1,515 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <jack/jack.h>
+#include "OOPS/Inc/OOPS.h"
+#include "OOPS/Inc/OOPSWavetables.h"
+
+#include "clis_poly.h"
+
+#define POLY_DECLICK        0.005f  // seconds a voice takes to start or stop
+
+// CLIS_POLY_WIDTH voices, in registers where the target has vectors that wide
+typedef float   poly_vf __attribute__((vector_size(CLIS_POLY_WIDTH * 4)));
+typedef int32_t poly_vi __attribute__((vector_size(CLIS_POLY_WIDTH * 4)));
+
+// on x86 the voices are also rendered with AVX2 when the CPU has it, which
+// reads a vector of table lanes in one gather. the vectors never cross a call
+// into code built without AVX, whatever GCC warns
+#if defined(__x86_64__) && defined(__GNUC__) && CLIS_POLY_WIDTH == 8
+#include <immintrin.h>
+#define POLY_AVX2 1
+#pragma GCC diagnostic ignored "-Wpsabi"
+#else
+#define POLY_AVX2 0
+#endif
+
+// the lanes of a where mask is set and of b elsewhere
+#define SELECT(mask, a, b) \
+    ((poly_vf)(((poly_vi)(a) & (mask)) | ((poly_vi)(b) & ~(mask))))
+
+// a lane of table for each lane of index
+#if POLY_AVX2
+__attribute__((target("avx2"))) static inline poly_vf
+gather_avx2(const float *table, poly_vi index)
+{
+    return (poly_vf)_mm256_i32gather_ps(table, (__m256i)index, 4);
+}
+
+#define GATHER(out, table, index, avx2) do { \
+    if(avx2) \
+        (out) = gather_avx2((table), (index)); \
+    else \
+        for(k = 0; k < CLIS_POLY_WIDTH; k++) \
+            (out)[k] = (table)[(index)[k]]; \
+} while(0)
+#else
+#define GATHER(out, table, index, avx2) \
+    for(k = 0; k < CLIS_POLY_WIDTH; k++) \
+        (out)[k] = (table)[(index)[k]]
+#endif
+
+static const float *
+wave_tables(clis_poly_wave wave)
+{
+    switch(wave) {
+        case CLIS_POLY_SQR: return squarewave;
+        case CLIS_POLY_TRI: return triangle;
+        default:            return sawtooth;
+    }
+}
+
+/**
+ * Set up an empty bank of voices.
+ *
+ * @param poly - the bank
+ * @param wave - the waveform every voice plays
+ */
+void
+clis_poly_init(clis_poly *poly, clis_poly_wave wave)
+{
+    memset(poly, 0, sizeof *poly);
+    poly->wave      = wave;
+    poly->release   = 1.0f / (POLY_DECLICK * OOPSGetSampleRate());
+}
+
+/**
+ * Pick the two bands of the mipmapped tables a voice mixes at freq, the same
+ * way as the OOPS oscillators do, so a voice sounds like an osc at the same
+ * pitch.
+ */
+static void
+set_freq(clis_poly *poly, size_t v, float freq)
+{
+    float lower = 20.0f;
+    int band = T20;
+
+    poly->inc[v]        = freq * (1.0f / OOPSGetSampleRate());
+    poly->inv_inc[v]    = poly->inc[v] > 0 ? 1.0f / poly->inc[v] : 0;
+
+    if(poly->wave == CLIS_POLY_SIN || poly->blep)
+        return;
+
+    while(band < T20480 && freq > lower * 2) {
+        lower *= 2;
+        band++;
+    }
+
+    poly->lower[v]      = wavetableOffset[band];
+    poly->lower_size[v] = wavetableSize[band];
+
+    if(freq <= 20.0f || band == T20480) {
+        poly->upper[v]      = poly->lower[v];
+        poly->upper_size[v] = poly->lower_size[v];
+        poly->weight[v]     = 1;
+    } else {
+        poly->upper[v]      = wavetableOffset[band + 1];
+        poly->upper_size[v] = wavetableSize[band + 1];
+        poly->weight[v]     = (lower * 2 - freq) / lower;
+    }
+}
+
+// the quietest released voice, or the oldest if none is released
+static size_t
+steal_voice(const clis_poly *poly)
+{
+    size_t v, quietest = CLIS_POLY_VOICES, oldest = 0;
+    float quiet = 2;
+
+    for(v = 0; v < poly->active; v++) {
+        if(poly->target[v] == 0 && poly->gain[v] < quiet) {
+            quietest    = v;
+            quiet       = poly->gain[v];
+        }
+        if(poly->started[v] < poly->started[oldest])
+            oldest = v;
+    }
+
+    return quietest < CLIS_POLY_VOICES ? quietest : oldest;
+}
+
+/**
+ * Start a note on a free voice, or on the voice already playing it. With
+ * every voice taken the quietest released voice is stolen, or the oldest if
+ * none is released.
+ *
+ * @param note - the MIDI note number
+ * @param velocity - the gain of the voice, 0 to 1
+ */
+void
+clis_poly_note_on(clis_poly *poly, uint8_t note, float velocity)
+{
+    size_t v;
+
+    for(v = 0; v < poly->active; v++) {
+        if(poly->note[v] == note && poly->target[v] > 0)
+            break;
+    }
+
+    if(v == poly->active && poly->active < CLIS_POLY_VOICES) {
+        v = poly->active++;
+        poly->phase[v]  = 0;
+        poly->gain[v]   = 0;
+    } else if(v == poly->active) {
+        v = steal_voice(poly);
+    }
+
+    set_freq(poly, v, OOPS_midiToFrequency(note));
+    poly->target[v]     = velocity;
+    poly->note[v]       = note;
+    poly->started[v]    = poly->age++;
+}
+
+/**
+ * Release the voice playing note, it fades out and is freed.
+ */
+void
+clis_poly_note_off(clis_poly *poly, uint8_t note)
+{
+    size_t v;
+
+    for(v = 0; v < poly->active; v++) {
+        if(poly->note[v] == note)
+            poly->target[v] = 0;
+    }
+}
+
+/**
+ * Release every voice.
+ */
+void
+clis_poly_all_off(clis_poly *poly)
+{
+    size_t v;
+
+    for(v = 0; v < poly->active; v++) {
+        poly->target[v] = 0;
+    }
+}
+
+/**
+ * Add a group of band limited voices to out. Each voice interpolates its two
+ * bands, mixes them and moves its gain towards its target by at most release
+ * a frame. Inlined into a render built for each target.
+ */
+static inline __attribute__((always_inline)) void
+render_bands(clis_poly *poly, size_t first, float *restrict out,
+             jack_nframes_t nframes, bool avx2)
+{
+    const float *tables = wave_tables(poly->wave);
+    poly_vf phase, inc, weight, gain, target, step, lower_size, upper_size;
+    poly_vf position, frac, a = { 0 }, b = { 0 }, c = { 0 }, d = { 0 };
+    poly_vf one     = (poly_vf){ 0 } + 1.0f;
+    poly_vf release = (poly_vf){ 0 } + poly->release;
+    poly_vi index, lower, upper;
+    jack_nframes_t j;
+    size_t k;
+    float sum;
+
+    memcpy(&phase, poly->phase + first, sizeof phase);
+    memcpy(&inc, poly->inc + first, sizeof inc);
+    memcpy(&lower, poly->lower + first, sizeof lower);
+    memcpy(&upper, poly->upper + first, sizeof upper);
+    memcpy(&lower_size, poly->lower_size + first, sizeof lower_size);
+    memcpy(&upper_size, poly->upper_size + first, sizeof upper_size);
+    memcpy(&weight, poly->weight + first, sizeof weight);
+    memcpy(&gain, poly->gain + first, sizeof gain);
+    memcpy(&target, poly->target + first, sizeof target);
+
+    for(j = 0; j < nframes; j++) {
+        phase += inc;
+        phase = SELECT(phase >= one, phase - one, phase);
+
+        // each band is followed by a copy of its first sample, index + 1
+        // needs no wrap
+        position = phase * lower_size;
+        index = __builtin_convertvector(position, poly_vi);
+        frac = position - __builtin_convertvector(index, poly_vf);
+        GATHER(a, tables, lower + index, avx2);
+        GATHER(b, tables, lower + index + 1, avx2);
+        a += (b - a) * frac;
+
+        position = phase * upper_size;
+        index = __builtin_convertvector(position, poly_vi);
+        frac = position - __builtin_convertvector(index, poly_vf);
+        GATHER(c, tables, upper + index, avx2);
+        GATHER(d, tables, upper + index + 1, avx2);
+        c += (d - c) * frac;
+
+        step = target - gain;
+        step = SELECT(step > release, release, step);
+        step = SELECT(step < -release, -release, step);
+        gain += step;
+
+        a = (c + (a - c) * weight) * gain;
+        for(k = 0, sum = 0; k < CLIS_POLY_WIDTH; k++)
+            sum += a[k];
+        out[j] += sum;
+    }
+
+    memcpy(poly->phase + first, &phase, sizeof phase);
+    memcpy(poly->gain + first, &gain, sizeof gain);
+}
+
+// the residual of a band limited step of 2 at phase 0, as in OOPS
+static inline __attribute__((always_inline)) poly_vf
+blep(poly_vf t, poly_vf inc, poly_vf inv_inc)
+{
+    poly_vf one = (poly_vf){ 0 } + 1.0f;
+    poly_vf after = t * inv_inc, before = (t - one) * inv_inc;
+
+    return SELECT(t < inc, after + after - after * after - one,
+            SELECT(t > one - inc, before * before + before + before + one,
+                (poly_vf){ 0 }));
+}
+
+// the residual of a band limited corner at phase 0 where the slope rises by 1
+// a frame
+static inline __attribute__((always_inline)) poly_vf
+blamp(poly_vf t, poly_vf inc, poly_vf inv_inc)
+{
+    poly_vf one = (poly_vf){ 0 } + 1.0f;
+    poly_vf after = one - t * inv_inc, before = one + (t - one) * inv_inc;
+
+    return SELECT(t < inc, after * after * after * (1.0f / 6),
+            SELECT(t > one - inc, before * before * before * (1.0f / 6),
+                (poly_vf){ 0 }));
+}
+
+// the lanes within a frame of a step or corner at phase 0
+static inline __attribute__((always_inline)) poly_vi
+near(poly_vf t, poly_vf inc)
+{
+    return (t < inc) | (t > 1.0f - inc);
+}
+
+// whether any lane of mask is set
+static inline __attribute__((always_inline)) bool
+any(poly_vi mask)
+{
+    uint64_t lanes[CLIS_POLY_WIDTH / 2], bits = 0;
+    size_t k;
+
+    memcpy(lanes, &mask, sizeof lanes);
+    for(k = 0; k < CLIS_POLY_WIDTH / 2; k++)
+        bits |= lanes[k];
+
+    return bits != 0;
+}
+
+// phase moved on by offset, wrapped into [0, 1)
+static inline __attribute__((always_inline)) poly_vf
+shift(poly_vf phase, float offset)
+{
+    poly_vf one = (poly_vf){ 0 } + 1.0f;
+
+    phase += offset;
+    return SELECT(phase >= one, phase - one, phase);
+}
+
+/**
+ * Add a group of PolyBLEP voices to out. The waves are drawn naively and
+ * corrected around their steps and corners, at the level and phase of the
+ * tables, so the voices read no memory but their own.
+ */
+static inline __attribute__((always_inline)) void
+render_bleps(clis_poly *poly, size_t first, float *restrict out,
+             jack_nframes_t nframes)
+{
+    poly_vf phase, inc, inv_inc, gain, target, step, a, q, h;
+    poly_vf one     = (poly_vf){ 0 } + 1.0f;
+    poly_vf release = (poly_vf){ 0 } + poly->release;
+    jack_nframes_t j;
+    size_t k;
+    float sum;
+
+    memcpy(&phase, poly->phase + first, sizeof phase);
+    memcpy(&inc, poly->inc + first, sizeof inc);
+    memcpy(&inv_inc, poly->inv_inc + first, sizeof inv_inc);
+    memcpy(&gain, poly->gain + first, sizeof gain);
+    memcpy(&target, poly->target + first, sizeof target);
+
+    for(j = 0; j < nframes; j++) {
+        phase += inc;
+        phase = SELECT(phase >= one, phase - one, phase);
+
+        // the corrections are only worked out when a lane is next to an
+        // edge, a few frames a period
+        switch(poly->wave) {
+            case CLIS_POLY_SQR:
+                h = shift(phase, 0.5f);
+                a = SELECT(phase < 0.5f, -one, one);
+                if(any(near(phase, inc) | near(h, inc)))
+                    a += blep(h, inc, inv_inc) - blep(phase, inc, inv_inc);
+                a *= PI * 0.25f;
+                break;
+            case CLIS_POLY_TRI:
+                q = shift(phase, 0.25f);
+                h = shift(q, 0.5f);
+                a = 2.0f * q - one;
+                a = 2.0f * SELECT(a < 0.0f, -a, a) - one;
+                if(any(near(q, inc) | near(h, inc)))
+                    a += 8.0f * inc * (blamp(h, inc, inv_inc)
+                            - blamp(q, inc, inv_inc));
+                a *= PI * PI * 0.75f * 0.125f;
+                break;
+            default:
+                a = 2.0f * phase - one;
+                if(any(near(phase, inc)))
+                    a -= blep(phase, inc, inv_inc);
+                a *= PI * 0.25f;
+                break;
+        }
+
+        step = target - gain;
+        step = SELECT(step > release, release, step);
+        step = SELECT(step < -release, -release, step);
+        gain += step;
+
+        a *= gain;
+        for(k = 0, sum = 0; k < CLIS_POLY_WIDTH; k++)
+            sum += a[k];
+        out[j] += sum;
+    }
+
+    memcpy(poly->phase + first, &phase, sizeof phase);
+    memcpy(poly->gain + first, &gain, sizeof gain);
+}
+
+/**
+ * Add a group of sine voices to out, interpolating the sine table. tCycle
+ * computes its sine by polynomial, the voices keep the table on purpose:
+ * its interpolation error, about 1e-6, is lost in the sum of the voices,
+ * and poly renders the same samples it always has.
+ */
+static inline __attribute__((always_inline)) void
+render_sines(clis_poly *poly, size_t first, float *restrict out,
+             jack_nframes_t nframes, bool avx2)
+{
+    poly_vf phase, inc, gain, target, step, position, frac;
+    poly_vf a = { 0 }, b = { 0 };
+    poly_vf size    = (poly_vf){ 0 } + SINE_TABLE_SIZE;
+    poly_vf one     = (poly_vf){ 0 } + 1.0f;
+    poly_vf release = (poly_vf){ 0 } + poly->release;
+    poly_vi index;
+    jack_nframes_t j;
+    size_t k;
+    float sum;
+
+    memcpy(&phase, poly->phase + first, sizeof phase);
+    memcpy(&inc, poly->inc + first, sizeof inc);
+    memcpy(&gain, poly->gain + first, sizeof gain);
+    memcpy(&target, poly->target + first, sizeof target);
+
+    for(j = 0; j < nframes; j++) {
+        phase += inc;
+        phase = SELECT(phase >= one, phase - one, phase);
+        position = phase * size;
+        index = __builtin_convertvector(position, poly_vi);
+        frac = position - __builtin_convertvector(index, poly_vf);
+
+        GATHER(a, sinewave, index, avx2);
+        GATHER(b, sinewave, (index + 1) & (SINE_TABLE_SIZE - 1), avx2);
+
+        step = target - gain;
+        step = SELECT(step > release, release, step);
+        step = SELECT(step < -release, -release, step);
+        gain += step;
+
+        a = (a + (b - a) * frac) * gain;
+        for(k = 0, sum = 0; k < CLIS_POLY_WIDTH; k++)
+            sum += a[k];
+        out[j] += sum;
+    }
+
+    memcpy(poly->phase + first, &phase, sizeof phase);
+    memcpy(poly->gain + first, &gain, sizeof gain);
+}
+
+static void
+render_groups(clis_poly *poly, float *restrict out, jack_nframes_t nframes)
+{
+    size_t first;
+
+    for(first = 0; first < poly->active; first += CLIS_POLY_WIDTH) {
+        if(poly->wave == CLIS_POLY_SIN)
+            render_sines(poly, first, out, nframes, false);
+        else if(poly->blep)
+            render_bleps(poly, first, out, nframes);
+        else
+            render_bands(poly, first, out, nframes, false);
+    }
+}
+
+#if POLY_AVX2
+__attribute__((target("avx2"))) static void
+render_groups_avx2(clis_poly *poly, float *restrict out,
+                   jack_nframes_t nframes)
+{
+    size_t first;
+
+    for(first = 0; first < poly->active; first += CLIS_POLY_WIDTH) {
+        if(poly->wave == CLIS_POLY_SIN)
+            render_sines(poly, first, out, nframes, true);
+        else if(poly->blep)
+            render_bleps(poly, first, out, nframes);
+        else
+            render_bands(poly, first, out, nframes, true);
+    }
+}
+#endif
+
+// move the last active voice into the slot of a voice that has faded out
+static void
+free_voice(clis_poly *poly, size_t v)
+{
+    size_t last = --poly->active;
+
+    poly->phase[v]      = poly->phase[last];
+    poly->inc[v]        = poly->inc[last];
+    poly->inv_inc[v]    = poly->inv_inc[last];
+    poly->weight[v]     = poly->weight[last];
+    poly->gain[v]       = poly->gain[last];
+    poly->target[v]     = poly->target[last];
+    poly->lower[v]      = poly->lower[last];
+    poly->upper[v]      = poly->upper[last];
+    poly->lower_size[v] = poly->lower_size[last];
+    poly->upper_size[v] = poly->upper_size[last];
+    poly->note[v]       = poly->note[last];
+    poly->started[v]    = poly->started[last];
+
+    poly->inc[last]     = 0;
+    poly->inv_inc[last] = 0;
+    poly->gain[last]    = 0;
+    poly->target[last]  = 0;
+}
+
+/**
+ * Render the mix of every voice into out, a group of CLIS_POLY_WIDTH voices
+ * at a time. Only the groups holding active voices are rendered, so the cost
+ * follows the number of notes sounding.
+ *
+ * @param poly - the bank
+ * @param out - the block to render
+ * @param nframes - the block length
+ */
+void
+clis_poly_render(clis_poly *poly, jack_default_audio_sample_t *out,
+                 jack_nframes_t nframes)
+{
+    size_t v;
+
+    memset(out, 0, nframes * sizeof *out);
+
+#if POLY_AVX2
+    if(__builtin_cpu_supports("avx2"))
+        render_groups_avx2(poly, out, nframes);
+    else
+#endif
+        render_groups(poly, out, nframes);
+
+    for(v = poly->active; v-- > 0;) {
+        if(poly->gain[v] == 0 && poly->target[v] == 0)
+            free_voice(poly, v);
+    }
+}
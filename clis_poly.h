@@ -0,0 +1,55 @@
+#ifndef CLIS_POLY_INC
+#define CLIS_POLY_INC
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <jack/jack.h>
+
+#define CLIS_POLY_WIDTH     8       // voices rendered at a time
+#define CLIS_POLY_VOICES    32      // a multiple of CLIS_POLY_WIDTH
+
+typedef enum clis_poly_wave {
+    CLIS_POLY_SAW,
+    CLIS_POLY_SQR,
+    CLIS_POLY_TRI,
+    CLIS_POLY_SIN
+} clis_poly_wave;
+
+/**
+ * A bank of wavetable voices kept as structure of arrays, so a group of
+ * CLIS_POLY_WIDTH voices is stepped by one vector operation. The sounding
+ * voices are always the first active ones, so the render stops at the last
+ * group with a voice in it.
+ */
+typedef struct clis_poly {
+    clis_poly_wave  wave;
+    bool            blep;           // PolyBLEP instead of the wavetables
+    size_t          active;
+    uint64_t        age;            // counts notes, to steal the oldest voice
+    float           release;        // gain change per frame of a note on / off
+    _Alignas(32) float phase[CLIS_POLY_VOICES];
+    _Alignas(32) float inc[CLIS_POLY_VOICES];
+    _Alignas(32) float inv_inc[CLIS_POLY_VOICES];
+    // weight of the lower of the two band limited tables the voice mixes
+    _Alignas(32) float weight[CLIS_POLY_VOICES];
+    _Alignas(32) float gain[CLIS_POLY_VOICES];
+    _Alignas(32) float target[CLIS_POLY_VOICES];
+    // the two bands of each voice, as offsets into the mipmapped tables of the
+    // wave, and their sizes
+    _Alignas(32) int32_t lower[CLIS_POLY_VOICES];
+    _Alignas(32) int32_t upper[CLIS_POLY_VOICES];
+    _Alignas(32) float lower_size[CLIS_POLY_VOICES];
+    _Alignas(32) float upper_size[CLIS_POLY_VOICES];
+    uint8_t         note[CLIS_POLY_VOICES];
+    uint64_t        started[CLIS_POLY_VOICES];
+} clis_poly;
+
+void    clis_poly_init(clis_poly *poly, clis_poly_wave wave);
+void    clis_poly_note_on(clis_poly *poly, uint8_t note, float velocity);
+void    clis_poly_note_off(clis_poly *poly, uint8_t note);
+void    clis_poly_all_off(clis_poly *poly);
+void    clis_poly_render(clis_poly *poly, jack_default_audio_sample_t *out,
+                         jack_nframes_t nframes);
+
+#endif // CLIS_POLY_INC
@@ -0,0 +1,265 @@
+#include <errno.h>
+#include <sched.h>
+#include <semaphore.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <jack/jack.h>
+#include <jack/ringbuffer.h>
+
+#include "clis.h"
+#include "clis_render.h"
+
+#define RENDER_CHANNELS     2
+#define RENDER_CHUNK        256     // frames mixed on the stack at a time
+#define WAV_HEADER_SIZE     58
+#define WAV_FORMAT_FLOAT    3
+
+// the ports played to the hardware and the capture of a render in progress
+static struct {
+    size_t              ports_length;
+    jack_port_t         *ports[CLIS_RENDER_MAX_PORTS][RENDER_CHANNELS];
+    jack_ringbuffer_t   *ring;
+    sem_t               written;
+    int                 sem_ready;
+    atomic_int          active;
+    size_t              remaining;  // frames left to capture, process only
+} render;
+
+/**
+ * Remember a pair of ports played to the hardware so a render can capture
+ * them. Called by clis_play_audio.
+ */
+void
+clis_render_add(jack_port_t *port_l, jack_port_t *port_r)
+{
+    size_t i;
+
+    for(i = 0; i < render.ports_length; i++) {
+        if(render.ports[i][0] == port_l && render.ports[i][1] == port_r)
+            return;
+    }
+
+    if(render.ports_length == CLIS_RENDER_MAX_PORTS)
+        return;
+
+    render.ports[render.ports_length][0] = port_l;
+    render.ports[render.ports_length][1] = port_r;
+    render.ports_length++;
+}
+
+/**
+ * Capture the mix of every played port into the render ring. Runs in the
+ * process thread after the clients own process callback.
+ *
+ * Renders run freewheeling so there is no deadline, when the writer falls
+ * behind this waits for it rather than dropping frames.
+ */
+void
+clis_render_process(jack_nframes_t nframes)
+{
+    jack_default_audio_sample_t *in[CLIS_RENDER_MAX_PORTS][RENDER_CHANNELS];
+    jack_default_audio_sample_t chunk[RENDER_CHUNK * RENDER_CHANNELS];
+    jack_nframes_t offset, length, i;
+    size_t p, c, bytes;
+
+    if(!atomic_load_explicit(&render.active, memory_order_acquire) ||
+            render.remaining == 0)
+        return;
+
+    for(p = 0; p < render.ports_length; p++) {
+        for(c = 0; c < RENDER_CHANNELS; c++) {
+            in[p][c] = (jack_default_audio_sample_t *)
+                jack_port_get_buffer(render.ports[p][c], nframes);
+        }
+    }
+
+    if(nframes > render.remaining)
+        nframes = (jack_nframes_t)render.remaining;
+
+    for(offset = 0; offset < nframes; offset += length) {
+        length = nframes - offset < RENDER_CHUNK
+            ? nframes - offset
+            : RENDER_CHUNK;
+        bytes = length * RENDER_CHANNELS * sizeof *chunk;
+
+        memset(chunk, 0, bytes);
+        for(p = 0; p < render.ports_length; p++) {
+            for(i = 0; i < length; i++) {
+                chunk[i * RENDER_CHANNELS]      += in[p][0][offset + i];
+                chunk[i * RENDER_CHANNELS + 1]  += in[p][1][offset + i];
+            }
+        }
+
+        while(jack_ringbuffer_write_space(render.ring) < bytes) {
+            if(!atomic_load_explicit(&render.active, memory_order_acquire))
+                return;
+            sched_yield();
+        }
+        jack_ringbuffer_write(render.ring, (const char *)chunk, bytes);
+    }
+
+    render.remaining -= nframes;
+    sem_post(&render.written);
+}
+
+static void
+put_le16(unsigned char *p, uint16_t v)
+{
+    p[0] = (unsigned char)v;
+    p[1] = (unsigned char)(v >> 8);
+}
+
+static void
+put_le32(unsigned char *p, uint32_t v)
+{
+    put_le16(p, (uint16_t)v);
+    put_le16(p + 2, (uint16_t)(v >> 16));
+}
+
+/**
+ * Write the header of a 32 bit float WAV file holding frames frames.
+ */
+static int
+write_wav_header(FILE *file, jack_nframes_t rate, uint32_t frames)
+{
+    unsigned char h[WAV_HEADER_SIZE];
+    uint32_t data = frames * RENDER_CHANNELS * sizeof(float);
+
+    memcpy(h, "RIFF", 4);
+    put_le32(h + 4, WAV_HEADER_SIZE - 8 + data);
+    memcpy(h + 8, "WAVEfmt ", 8);
+    put_le32(h + 16, 18);
+    put_le16(h + 20, WAV_FORMAT_FLOAT);
+    put_le16(h + 22, RENDER_CHANNELS);
+    put_le32(h + 24, rate);
+    put_le32(h + 28, rate * RENDER_CHANNELS * sizeof(float));
+    put_le16(h + 32, RENDER_CHANNELS * sizeof(float));
+    put_le16(h + 34, 32);
+    put_le16(h + 36, 0);
+    memcpy(h + 38, "fact", 4);
+    put_le32(h + 42, 4);
+    put_le32(h + 46, frames);
+    memcpy(h + 50, "data", 4);
+    put_le32(h + 54, data);
+
+    return fseek(file, 0, SEEK_SET) == 0 &&
+        fwrite(h, sizeof h, 1, file) == 1 ? 0 : -1;
+}
+
+static double
+elapsed(const struct timespec *start)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (double)(now.tv_sec - start->tv_sec) +
+        (double)(now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+/**
+ * Render seconds of whatever the client plays to the hardware into a file as
+ * fast as the server can go, by freewheeling it. Files ending in '.wav' are
+ * written as 32 bit float WAV, anything else as raw interleaved floats.
+ *
+ * Call this instead of clis_run once the client is playing. The render is
+ * interrupted by the same signals as clis_run.
+ *
+ * @param client - an active client
+ * @param path - the file to write, two channels at the servers sample rate
+ * @param seconds - the length of the render
+ * @return CLIS_OK or an error code according to clis_rc
+ */
+clis_rc
+clis_render(jack_client_t *client, const char *path, double seconds)
+{
+    jack_nframes_t rate = jack_get_sample_rate(client);
+    size_t frames       = (size_t)(seconds * rate);
+    size_t frame_size   = RENDER_CHANNELS * sizeof(float);
+    size_t length       = strlen(path);
+    int wav             = length >= 4 && strcmp(path + length - 4, ".wav") == 0;
+    char block[RENDER_CHUNK * RENDER_CHANNELS * sizeof(float)];
+    size_t written = 0, n;
+    struct timespec start;
+    double took;
+    clis_rc rc = CLIS_OK;
+    FILE *file;
+
+    if(render.ring == NULL) {
+        render.ring = jack_ringbuffer_create(rate * frame_size);
+        if(render.ring == NULL)
+            return CLIS_E_ALLOC_RENDER;
+    }
+    if(!render.sem_ready) {
+        if(sem_init(&render.written, 0, 0) != 0)
+            return CLIS_E_ALLOC_RENDER;
+        render.sem_ready = 1;
+    }
+
+    file = fopen(path, "wb");
+    if(file == NULL)
+        return CLIS_E_RENDER_FILE;
+
+    if(wav && write_wav_header(file, rate, 0) != 0) {
+        fclose(file);
+        return CLIS_E_RENDER_FILE;
+    }
+
+    jack_ringbuffer_reset(render.ring);
+    render.remaining = frames;
+    atomic_store_explicit(&render.active, 1, memory_order_release);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if(jack_set_freewheel(client, 1) != 0) {
+        atomic_store(&render.active, 0);
+        fclose(file);
+        return CLIS_E_FREEWHEEL;
+    }
+
+    is_running = 1;
+    while(written < frames && is_running && rc == CLIS_OK) {
+        if(sem_wait(&render.written) != 0 && errno != EINTR)
+            break;
+
+        while((n = jack_ringbuffer_read(render.ring, block, sizeof block)) > 0) {
+            if(fwrite(block, n, 1, file) != 1) {
+                rc = CLIS_E_RENDER_FILE;
+                break;
+            }
+            written += n / frame_size;
+        }
+    }
+
+    atomic_store_explicit(&render.active, 0, memory_order_release);
+    jack_set_freewheel(client, 0);
+    took = elapsed(&start);
+
+    if(wav && rc == CLIS_OK && write_wav_header(file, rate, written) != 0)
+        rc = CLIS_E_RENDER_FILE;
+    if(fclose(file) != 0 && rc == CLIS_OK)
+        rc = CLIS_E_RENDER_FILE;
+
+    fprintf(stderr, "rendered %.2fs in %.2fs, %.1fx realtime\n",
+            (double)written / rate, took,
+            took > 0 ? (double)written / rate / took : 0.0);
+
+    return rc;
+}
+
+/**
+ * Free the render ring, if a render made one. The client must be closed
+ * first.
+ */
+void
+clis_render_free(void)
+{
+    if(render.ring)
+        jack_ringbuffer_free(render.ring);
+    if(render.sem_ready)
+        sem_destroy(&render.written);
+
+    memset(&render, 0, sizeof render);
+}
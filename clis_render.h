@@ -0,0 +1,16 @@
+#ifndef CLIS_RENDER_INC
+#define CLIS_RENDER_INC
+
+#include <jack/jack.h>
+
+#include "clis.h"
+
+// the most port pairs played by one client that a render can mix
+#define CLIS_RENDER_MAX_PORTS   16
+
+void    clis_render_add(jack_port_t *port_l, jack_port_t *port_r);
+void    clis_render_process(jack_nframes_t nframes);
+clis_rc clis_render(jack_client_t *client, const char *path, double seconds);
+void    clis_render_free(void);
+
+#endif // CLIS_RENDER_INC
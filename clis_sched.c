@@ -0,0 +1,479 @@
+// pthread_setaffinity_np and the CPU_* macros
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <semaphore.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <jack/jack.h>
+#include <jack/thread.h>
+
+#include "clis_sched.h"
+
+#define TASK_EMPTY  -1
+#define TASK_ABORT  -2
+
+// times a thread spins waiting for others before it gives up its core, a
+// thread it waits on may be queued behind it at the same realtime priority
+#define SPINS       4096
+
+static inline void
+cpu_relax(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+
+static inline uint64_t
+now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+/* Chase-Lev deque, following the C11 formulation of Le, Pop, Cohen and
+ * Zappa Nardelli. Only the owning worker pushes and takes, anyone may steal.
+ * Every task is pushed once per period so the capacity never needs to grow. */
+
+static int
+deque_init(clis_deque *deque, size_t capacity)
+{
+    size_t size = 1;
+
+    while(size < capacity)
+        size <<= 1;
+
+    deque->tasks = calloc(size, sizeof *deque->tasks);
+    if(deque->tasks == NULL)
+        return -1;
+
+    deque->mask = size - 1;
+    atomic_init(&deque->top, 0);
+    atomic_init(&deque->bottom, 0);
+
+    return 0;
+}
+
+static void
+deque_push(clis_deque *deque, long task)
+{
+    long b = atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+
+    atomic_store_explicit(&deque->tasks[b & deque->mask], task,
+            memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&deque->bottom, b + 1, memory_order_relaxed);
+}
+
+static long
+deque_take(clis_deque *deque)
+{
+    long b = atomic_load_explicit(&deque->bottom, memory_order_relaxed) - 1;
+    long t, task;
+
+    atomic_store_explicit(&deque->bottom, b, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    t = atomic_load_explicit(&deque->top, memory_order_relaxed);
+
+    if(t > b) {
+        atomic_store_explicit(&deque->bottom, b + 1, memory_order_relaxed);
+        return TASK_EMPTY;
+    }
+
+    task = atomic_load_explicit(&deque->tasks[b & deque->mask],
+            memory_order_relaxed);
+
+    if(t == b) {
+        // last task, race the thieves for it
+        if(!atomic_compare_exchange_strong_explicit(&deque->top, &t, t + 1,
+                    memory_order_seq_cst, memory_order_relaxed))
+            task = TASK_EMPTY;
+        atomic_store_explicit(&deque->bottom, b + 1, memory_order_relaxed);
+    }
+
+    return task;
+}
+
+static long
+deque_steal(clis_deque *deque)
+{
+    long t = atomic_load_explicit(&deque->top, memory_order_acquire);
+    long b, task;
+
+    atomic_thread_fence(memory_order_seq_cst);
+    b = atomic_load_explicit(&deque->bottom, memory_order_acquire);
+
+    if(t >= b)
+        return TASK_EMPTY;
+
+    task = atomic_load_explicit(&deque->tasks[t & deque->mask],
+            memory_order_relaxed);
+    if(!atomic_compare_exchange_strong_explicit(&deque->top, &t, t + 1,
+                memory_order_seq_cst, memory_order_relaxed))
+        return TASK_ABORT;
+
+    return task;
+}
+
+/**
+ * Order the graph and work out the dependencies of every node.
+ *
+ * @param sched - the schedule to compile, must be zeroed
+ * @param nodes_length - the number of nodes in the graph
+ * @param edges - pairs of node indices, the first is read by the second
+ * @param edges_length - the number of edges
+ * @param run - renders one node
+ * @param arg - passed to run
+ * @return 0 on success, -1 if allocation failed or -2 if the graph has a cycle
+ */
+int
+clis_sched_compile(clis_sched *sched, size_t nodes_length,
+                   const size_t (*edges)[2], size_t edges_length,
+                   clis_sched_run_cb run, void *arg)
+{
+    size_t i, head = 0, tail = 0;
+    size_t *succ, *pending;
+
+    sched->run          = run;
+    sched->arg          = arg;
+    sched->tasks_length = nodes_length;
+
+    if(nodes_length == 0)
+        return 0;
+
+    sched->tasks    = calloc(nodes_length, sizeof *sched->tasks);
+    sched->order    = calloc(nodes_length, sizeof *sched->order);
+    sched->roots    = calloc(nodes_length, sizeof *sched->roots);
+    succ            = calloc(edges_length + 1, sizeof *succ);
+    pending         = calloc(nodes_length, sizeof *pending);
+
+    if(!sched->tasks || !sched->order || !sched->roots || !succ || !pending) {
+        free(succ);
+        free(pending);
+        return -1;
+    }
+
+    // the successor lists are slices of one block, the first task owns it
+    for(i = 0; i < edges_length; i++) {
+        sched->tasks[edges[i][0]].succ_length++;
+        sched->tasks[edges[i][1]].deps++;
+    }
+    for(i = 0; i < nodes_length; i++) {
+        sched->tasks[i].succ    = succ;
+        succ                   += sched->tasks[i].succ_length;
+        sched->tasks[i].succ_length = 0;
+        pending[i]              = sched->tasks[i].deps;
+    }
+    for(i = 0; i < edges_length; i++) {
+        clis_task *from = &sched->tasks[edges[i][0]];
+
+        from->succ[from->succ_length++] = edges[i][1];
+    }
+
+    // Kahn's algorithm, the nodes that depend on nothing are the roots that
+    // start every parallel period
+    for(i = 0; i < nodes_length; i++) {
+        if(pending[i] == 0) {
+            sched->roots[sched->roots_length++] = i;
+            sched->order[tail++] = i;
+        }
+    }
+    while(head < tail) {
+        clis_task *task = &sched->tasks[sched->order[head++]];
+
+        for(i = 0; i < task->succ_length; i++) {
+            if(--pending[task->succ[i]] == 0)
+                sched->order[tail++] = task->succ[i];
+        }
+    }
+
+    free(pending);
+
+    return tail == nodes_length ? 0 : -2;
+}
+
+static void
+run_task(clis_sched *sched, clis_worker *worker, size_t index)
+{
+    clis_task *task = &sched->tasks[index];
+    uint64_t start, elapsed;
+    size_t i;
+
+    start = now_ns();
+    sched->run(sched->arg, index, sched->offset, sched->nframes);
+    elapsed = now_ns() - start;
+
+    atomic_store_explicit(&task->last_ns, elapsed, memory_order_relaxed);
+    atomic_fetch_add_explicit(&task->total_ns, elapsed, memory_order_relaxed);
+    atomic_fetch_add_explicit(&task->runs, 1, memory_order_relaxed);
+    if(elapsed > atomic_load_explicit(&task->max_ns, memory_order_relaxed))
+        atomic_store_explicit(&task->max_ns, elapsed, memory_order_relaxed);
+
+    // successors are queued before this task counts as done so the period
+    // cannot end with work still waiting to be picked up
+    if(worker == NULL) {
+        atomic_fetch_add_explicit(&sched->done, 1, memory_order_relaxed);
+        return;
+    }
+
+    for(i = 0; i < task->succ_length; i++) {
+        clis_task *next = &sched->tasks[task->succ[i]];
+
+        if(atomic_fetch_sub_explicit(&next->pending, 1,
+                    memory_order_acq_rel) == 1)
+            deque_push(&worker->deque, (long)task->succ[i]);
+    }
+
+    atomic_fetch_add_explicit(&sched->done, 1, memory_order_release);
+}
+
+/**
+ * Render tasks until every task of the period is done, taking from the
+ * workers own deque first and stealing from the others when it runs dry.
+ */
+static void
+work(clis_sched *sched, clis_worker *worker)
+{
+    size_t i, victim, spins = 0;
+    long task;
+
+    while(atomic_load_explicit(&sched->done, memory_order_acquire)
+            < sched->tasks_length) {
+
+        task = deque_take(&worker->deque);
+
+        for(i = 1; task < 0 && i < sched->workers_length; i++) {
+            victim = (worker->id + i) % sched->workers_length;
+            task = deque_steal(&sched->workers[victim].deque);
+        }
+
+        if(task < 0) {
+            if(++spins % SPINS == 0)
+                sched_yield();
+            else
+                cpu_relax();
+            continue;
+        }
+
+        spins = 0;
+        run_task(sched, worker, (size_t)task);
+    }
+}
+
+static void *
+worker_main(void *arg)
+{
+    clis_worker *worker = (clis_worker *)arg;
+    clis_sched *sched   = worker->sched;
+    cpu_set_t set;
+
+    // pin each helper to a core of its own, the JACK thread is left where it
+    // is so the barrier never relies on a helper sharing its core running
+    if(worker->cpu >= 0) {
+        CPU_ZERO(&set);
+        CPU_SET(worker->cpu, &set);
+        pthread_setaffinity_np(pthread_self(), sizeof set, &set);
+    }
+
+    for(;;) {
+        while(sem_wait(&worker->wake) != 0 && errno == EINTR)
+            ;
+
+        if(atomic_load(&sched->quit))
+            break;
+
+        work(sched, worker);
+
+        // the last helper out lets the JACK thread through the barrier
+        if(atomic_fetch_sub_explicit(&sched->active, 1,
+                    memory_order_acq_rel) == 1)
+            sem_post(&sched->idle);
+    }
+
+    return NULL;
+}
+
+/**
+ * Start the helper threads. They run at the JACK clients realtime priority
+ * and sleep until a period is handed to them.
+ *
+ * @param sched - a compiled schedule
+ * @param client - the client whose process thread runs the schedule
+ * @param workers_length - the total number of threads rendering a period,
+ *  including the JACK process thread. 1 or less renders serially, more than
+ *  the cores the process may run on is clamped to that many.
+ * @return 0 on success or -1 if a worker could not be started
+ */
+int
+clis_sched_start(clis_sched *sched, jack_client_t *client,
+                 size_t workers_length)
+{
+    size_t i, cpus = 0;
+    int cpu = 0;
+    cpu_set_t set;
+
+    if(sched_getaffinity(0, sizeof set, &set) == 0)
+        cpus = (size_t)CPU_COUNT(&set);
+
+    if(cpus > 0 && workers_length > cpus)
+        workers_length = cpus;
+    if(workers_length < 1)
+        workers_length = 1;
+
+    sched->workers = calloc(workers_length, sizeof *sched->workers);
+    if(sched->workers == NULL)
+        return -1;
+
+    sched->workers_length = workers_length;
+    atomic_init(&sched->quit, 0);
+    atomic_init(&sched->active, 0);
+
+    for(i = 0; i < workers_length; i++) {
+        clis_worker *worker = &sched->workers[i];
+
+        worker->sched   = sched;
+        worker->id      = i;
+        worker->cpu     = -1;
+
+        if(deque_init(&worker->deque, sched->tasks_length) != 0 ||
+                sem_init(&worker->wake, 0, 0) != 0)
+            return -1;
+    }
+
+    if(sem_init(&sched->idle, 0, 0) != 0)
+        return -1;
+    sched->idle_init = 1;
+
+    // helper i takes the i-th core of the affinity mask, no two share one
+    for(i = 1; cpus > 1 && i < workers_length; i++) {
+        while(!CPU_ISSET(cpu, &set))
+            cpu++;
+        sched->workers[i].cpu = cpu++;
+    }
+
+    for(i = 1; i < workers_length; i++) {
+        clis_worker *worker = &sched->workers[i];
+
+        if(jack_client_create_thread(client, &worker->thread,
+                    jack_client_real_time_priority(client),
+                    jack_is_realtime(client), worker_main, worker) != 0)
+            return -1;
+
+        worker->started = 1;
+    }
+
+    return 0;
+}
+
+/**
+ * Render one period of the graph, or the frames offset to offset + nframes of
+ * it. Called from the JACK process callback, with helpers it hands the roots
+ * out, works alongside them and waits on a barrier for the last task before
+ * returning.
+ */
+void
+clis_sched_run(clis_sched *sched, jack_nframes_t offset, jack_nframes_t nframes)
+{
+    size_t i;
+
+    sched->offset   = offset;
+    sched->nframes  = nframes;
+
+    if(sched->workers_length <= 1) {
+        for(i = 0; i < sched->tasks_length; i++) {
+            run_task(sched, NULL, sched->order[i]);
+        }
+        return;
+    }
+
+    // the helpers are parked so their deques can be filled from here
+    for(i = 0; i < sched->tasks_length; i++) {
+        atomic_store_explicit(&sched->tasks[i].pending, sched->tasks[i].deps,
+                memory_order_relaxed);
+    }
+    for(i = 0; i < sched->roots_length; i++) {
+        clis_worker *worker = &sched->workers[i % sched->workers_length];
+
+        deque_push(&worker->deque, (long)sched->roots[i]);
+    }
+    atomic_store(&sched->done, 0);
+    atomic_store(&sched->active, sched->workers_length - 1);
+
+    for(i = 1; i < sched->workers_length; i++) {
+        sem_post(&sched->workers[i].wake);
+    }
+
+    work(sched, &sched->workers[0]);
+
+    // end of period barrier, nobody may touch the deques or buffers after
+    // this. the last helper posts idle, spin on it a while and then sleep on
+    // it, a helper that cannot get a core while this thread spins would
+    // otherwise hold the period up for good
+    for(i = 0; sem_trywait(&sched->idle) != 0; i++) {
+        if(i < SPINS) {
+            cpu_relax();
+            continue;
+        }
+
+        while(sem_wait(&sched->idle) != 0 && errno == EINTR)
+            ;
+        break;
+    }
+}
+
+/**
+ * Stop and join the helper threads. The JACK client must no longer be calling
+ * clis_sched_run.
+ */
+void
+clis_sched_stop(clis_sched *sched)
+{
+    size_t i;
+
+    atomic_store(&sched->quit, 1);
+
+    for(i = 1; i < sched->workers_length; i++) {
+        clis_worker *worker = &sched->workers[i];
+
+        if(!worker->started)
+            continue;
+
+        sem_post(&worker->wake);
+        pthread_join(worker->thread, NULL);
+        worker->started = 0;
+    }
+}
+
+void
+clis_sched_free(clis_sched *sched)
+{
+    size_t i;
+
+    clis_sched_stop(sched);
+
+    for(i = 0; i < sched->workers_length; i++) {
+        free(sched->workers[i].deque.tasks);
+        sem_destroy(&sched->workers[i].wake);
+    }
+
+    if(sched->idle_init)
+        sem_destroy(&sched->idle);
+
+    if(sched->tasks != NULL && sched->tasks_length > 0)
+        free(sched->tasks[0].succ);
+
+    free(sched->workers);
+    free(sched->tasks);
+    free(sched->order);
+    free(sched->roots);
+
+    memset(sched, 0, sizeof *sched);
+}
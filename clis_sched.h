@@ -0,0 +1,77 @@
+#ifndef CLIS_SCHED_INC
+#define CLIS_SCHED_INC
+
+#include <semaphore.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <jack/jack.h>
+
+// renders the frames offset to offset + nframes of one node of the graph
+typedef void (*clis_sched_run_cb)(void *arg, size_t node,
+                                  jack_nframes_t offset,
+                                  jack_nframes_t nframes);
+
+typedef struct clis_task {
+    size_t          deps;           // number of nodes this one reads from
+    atomic_size_t   pending;        // deps not yet rendered this period
+    size_t          succ_length;
+    size_t          *succ;          // nodes that read from this one
+    // timings of the nodes render, written by whichever worker ran it
+    atomic_uint_fast64_t last_ns;
+    atomic_uint_fast64_t max_ns;
+    atomic_uint_fast64_t total_ns;
+    atomic_uint_fast64_t runs;
+} clis_task;
+
+// Chase-Lev work stealing deque of task indices with a fixed capacity
+typedef struct clis_deque {
+    atomic_long     top;
+    atomic_long     bottom;
+    size_t          mask;
+    atomic_long     *tasks;
+} clis_deque;
+
+struct clis_sched;
+
+typedef struct clis_worker {
+    struct clis_sched   *sched;
+    size_t              id;
+    int                 cpu;    // the core a helper is pinned to, or -1
+    clis_deque          deque;
+    sem_t               wake;
+    jack_native_thread_t thread;
+    int                 started;
+} clis_worker;
+
+typedef struct clis_sched {
+    size_t          tasks_length;
+    clis_task       *tasks;
+    size_t          *order;         // topological order for serial periods
+    size_t          roots_length;
+    size_t          *roots;         // nodes with no dependencies
+    // worker 0 is the JACK process thread, the rest are helper threads
+    size_t          workers_length;
+    clis_worker     *workers;
+    clis_sched_run_cb run;
+    void            *arg;
+    jack_nframes_t  offset;
+    jack_nframes_t  nframes;
+    atomic_size_t   done;           // tasks rendered this period
+    atomic_size_t   active;         // helpers still working this period
+    sem_t           idle;           // posted by the last helper to finish
+    int             idle_init;
+    atomic_int      quit;
+} clis_sched;
+
+int     clis_sched_compile(clis_sched *sched, size_t nodes_length,
+                           const size_t (*edges)[2], size_t edges_length,
+                           clis_sched_run_cb run, void *arg);
+int     clis_sched_start(clis_sched *sched, jack_client_t *client,
+                         size_t workers_length);
+void    clis_sched_run(clis_sched *sched, jack_nframes_t offset,
+                       jack_nframes_t nframes);
+void    clis_sched_stop(clis_sched *sched);
+void    clis_sched_free(clis_sched *sched);
+
+#endif // CLIS_SCHED_INC
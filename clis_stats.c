@@ -0,0 +1,351 @@
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <jack/jack.h>
+
+#include "clis.h"
+#include "clis_stats.h"
+
+// loads are kept in hundredths of a percent of the period
+#define LOAD_SCALE      10000.0
+
+// the dsp load counters of the client and the thread that reports them. the
+// process thread is the only writer of the counters but interval_load, so it
+// updates them with plain loads and stores and never waits on a reader.
+// interval_load is also reset by the reporter at the end of each interval
+static struct {
+    jack_client_t       *client;
+    uint64_t            start;          // process thread only
+    atomic_uint_fast64_t periods;
+    atomic_uint_fast64_t buckets[CLIS_STATS_BUCKETS];
+    atomic_uint_fast64_t process_ns;
+    atomic_uint_fast64_t budget_ns;
+    atomic_uint         max_load;       // since the client was opened
+    atomic_uint         interval_load;  // since the last report
+    atomic_uint_fast64_t xruns;
+    // the reporter
+    double              interval;
+    int                 wake[2];
+    pthread_t           thread;
+    bool                started;
+} stats = {
+    .wake = { -1, -1 },
+};
+
+static inline uint64_t
+now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+// counters only ever written by one thread, no read-modify-write is needed
+static inline void
+add(atomic_uint_fast64_t *counter, uint64_t n)
+{
+    atomic_store_explicit(counter,
+            atomic_load_explicit(counter, memory_order_relaxed) + n,
+            memory_order_relaxed);
+}
+
+static inline void
+raise_to(atomic_uint *max, unsigned int load)
+{
+    if(load > atomic_load_explicit(max, memory_order_relaxed))
+        atomic_store_explicit(max, load, memory_order_relaxed);
+}
+
+// for a max another thread resets, a load raised over a stale max would be
+// lost to the interval that follows the reset. lock free, the loop only
+// runs again when the reset lands in between
+static inline void
+raise_shared(atomic_uint *max, unsigned int load)
+{
+    unsigned int seen = atomic_load_explicit(max, memory_order_relaxed);
+
+    while(load > seen && !atomic_compare_exchange_weak_explicit(max, &seen,
+                load, memory_order_relaxed, memory_order_relaxed))
+        ;
+}
+
+// JACK xrun callback, called from a JACK thread
+static int
+xrun(void *arg)
+{
+    (void)arg;
+
+    atomic_fetch_add_explicit(&stats.xruns, 1, memory_order_relaxed);
+
+    return 0;
+}
+
+/**
+ * Start counting the xruns of the client. The process callback wrapped by
+ * clis_init_client is timed from then on. Called before the client is
+ * activated.
+ *
+ * @return CLIS_OK or an error code according to clis_rc
+ */
+clis_rc
+clis_stats_init(jack_client_t *client)
+{
+    stats.client = client;
+
+    if(jack_set_xrun_callback(client, xrun, NULL) != 0)
+        return CLIS_E_JACK_CALLBACK;
+
+    return CLIS_OK;
+}
+
+/**
+ * Mark the start of the process callback. Called from the process thread.
+ */
+void
+clis_stats_begin(void)
+{
+    stats.start = now_ns();
+}
+
+/**
+ * Add the time since clis_stats_begin to the histogram, against the length of
+ * the period. Called from the process thread, this never blocks.
+ *
+ * @param nframes - the period length
+ */
+void
+clis_stats_end(jack_nframes_t nframes)
+{
+    uint64_t took = now_ns() - stats.start;
+    jack_nframes_t rate = jack_get_sample_rate(stats.client);
+    uint64_t budget;
+    double load;
+    size_t bucket;
+
+    if(rate == 0 || nframes == 0)
+        return;
+
+    budget  = (uint64_t)nframes * 1000000000u / rate;
+    load    = (double)took / (double)budget;
+    bucket  = load >= 1.0
+        ? CLIS_STATS_BUCKETS - 1
+        : (size_t)(load / CLIS_STATS_BUCKET_LOAD);
+
+    add(&stats.buckets[bucket], 1);
+    add(&stats.process_ns, took);
+    add(&stats.budget_ns, budget);
+    raise_to(&stats.max_load, (unsigned int)(load * LOAD_SCALE));
+    raise_shared(&stats.interval_load, (unsigned int)(load * LOAD_SCALE));
+    // written last, a reader never sees more periods than were bucketed
+    atomic_store_explicit(&stats.periods,
+            atomic_load_explicit(&stats.periods, memory_order_relaxed) + 1,
+            memory_order_release);
+}
+
+/**
+ * Copy the counters. May be called from any thread, the copy may be a period
+ * behind in places but never blocks the process thread.
+ */
+void
+clis_stats_read(clis_stats *out)
+{
+    size_t i;
+
+    out->periods    = atomic_load_explicit(&stats.periods,
+                                           memory_order_acquire);
+    for(i = 0; i < CLIS_STATS_BUCKETS; i++) {
+        out->buckets[i] = atomic_load_explicit(&stats.buckets[i],
+                                               memory_order_relaxed);
+    }
+    out->process_ns = atomic_load_explicit(&stats.process_ns,
+                                           memory_order_relaxed);
+    out->budget_ns  = atomic_load_explicit(&stats.budget_ns,
+                                           memory_order_relaxed);
+    out->max_load   = (float)(atomic_load_explicit(&stats.max_load,
+                                      memory_order_relaxed) / LOAD_SCALE);
+    out->xruns      = atomic_load_explicit(&stats.xruns,
+                                           memory_order_relaxed);
+}
+
+static double
+mean_load(const clis_stats *s)
+{
+    return s->budget_ns ? (double)s->process_ns / s->budget_ns : 0.0;
+}
+
+/**
+ * The upper bound of the bucket a fraction of the periods fall under.
+ */
+static double
+percentile(const clis_stats *s, double fraction)
+{
+    uint64_t total = 0, want;
+    size_t i;
+
+    for(i = 0; i < CLIS_STATS_BUCKETS; i++)
+        total += s->buckets[i];
+
+    want = (uint64_t)(fraction * (double)total + 0.5);
+    total = 0;
+    for(i = 0; i < CLIS_STATS_BUCKETS - 1; i++) {
+        total += s->buckets[i];
+        if(total >= want)
+            break;
+    }
+
+    return (double)(i + 1) * CLIS_STATS_BUCKET_LOAD;
+}
+
+/**
+ * Print the histogram of the process time against the period length.
+ *
+ * @param s - counters from clis_stats_read
+ * @param file - where to print them
+ */
+void
+clis_stats_report(const clis_stats *s, FILE *file)
+{
+    size_t i;
+
+    fprintf(file, "%-16s %10s\n", "dsp load", "periods");
+
+    for(i = 0; i < CLIS_STATS_BUCKETS; i++) {
+        char range[16];
+
+        if(s->buckets[i] == 0)
+            continue;
+
+        if(i == CLIS_STATS_BUCKETS - 1) {
+            snprintf(range, sizeof range, ">100%%");
+        } else {
+            snprintf(range, sizeof range, "%.0f-%.0f%%",
+                     (double)i * CLIS_STATS_BUCKET_LOAD * 100.0,
+                     (double)(i + 1) * CLIS_STATS_BUCKET_LOAD * 100.0);
+        }
+        fprintf(file, "%-16s %10llu\n", range,
+                (unsigned long long)s->buckets[i]);
+    }
+
+    fprintf(file, "mean %.1f%% max %.1f%% xruns %llu\n",
+            mean_load(s) * 100.0, s->max_load * 100.0,
+            (unsigned long long)s->xruns);
+}
+
+// prints one line of the load since the previous line every interval
+static void *
+stats_main(void *arg)
+{
+    clis_stats last, now, delta;
+    int timeout = (int)(stats.interval * 1000.0);
+    struct pollfd wake = { stats.wake[0], POLLIN, 0 };
+    double p99;
+    size_t i;
+    int rc;
+
+    (void)arg;
+
+    clis_stats_read(&last);
+
+    for(;;) {
+        rc = poll(&wake, 1, timeout);
+        if(rc < 0 && errno == EINTR)
+            continue;
+        if(rc != 0)
+            break;
+
+        clis_stats_read(&now);
+        delta.periods       = now.periods - last.periods;
+        delta.process_ns    = now.process_ns - last.process_ns;
+        delta.budget_ns     = now.budget_ns - last.budget_ns;
+        delta.xruns         = now.xruns - last.xruns;
+        for(i = 0; i < CLIS_STATS_BUCKETS; i++) {
+            delta.buckets[i] = now.buckets[i] - last.buckets[i];
+        }
+        delta.max_load = (float)(atomic_exchange_explicit(
+                    &stats.interval_load, 0, memory_order_relaxed) /
+                    LOAD_SCALE);
+        last = now;
+
+        p99 = percentile(&delta, 0.99);
+        fprintf(stderr, "dsp %s: %llu periods, load mean %.1f%% p99 %s%.0f%% "
+                "max %.1f%%, %llu late, %llu xruns\n",
+                jack_get_client_name(stats.client),
+                (unsigned long long)delta.periods,
+                mean_load(&delta) * 100.0,
+                p99 > 1.0 ? ">" : "<", (p99 > 1.0 ? 1.0 : p99) * 100.0,
+                delta.max_load * 100.0,
+                (unsigned long long)delta.buckets[CLIS_STATS_BUCKETS - 1],
+                (unsigned long long)delta.xruns);
+    }
+
+    return NULL;
+}
+
+/**
+ * Start a thread that prints the dsp load and xruns of the client on stderr
+ * every interval. It only reads the counters, the process thread never waits
+ * on it.
+ *
+ * @param interval - seconds between reports
+ * @return CLIS_OK or an error code according to clis_rc
+ */
+clis_rc
+clis_stats_start(double interval)
+{
+    sigset_t all, old;
+    int rc;
+
+    if(stats.client == NULL || interval <= 0)
+        return CLIS_E_STATS;
+
+    stats.interval = interval;
+
+    if(pipe(stats.wake) != 0)
+        return CLIS_E_STATS;
+
+    // signals are left to the main thread so they still interrupt clis_run
+    sigfillset(&all);
+    pthread_sigmask(SIG_SETMASK, &all, &old);
+    rc = pthread_create(&stats.thread, NULL, stats_main, NULL);
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+
+    if(rc != 0)
+        return CLIS_E_STATS;
+
+    stats.started = true;
+
+    return CLIS_OK;
+}
+
+/**
+ * Stop the reporter thread. The client must still be open.
+ */
+void
+clis_stats_stop(void)
+{
+    ssize_t n;
+
+    if(stats.started) {
+        n = write(stats.wake[1], "", 1);
+        (void)n;
+        pthread_join(stats.thread, NULL);
+        stats.started = false;
+    }
+
+    if(stats.wake[0] >= 0) {
+        close(stats.wake[0]);
+        close(stats.wake[1]);
+    }
+    stats.wake[0] = -1;
+    stats.wake[1] = -1;
+}
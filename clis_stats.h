@@ -0,0 +1,33 @@
+#ifndef CLIS_STATS_INC
+#define CLIS_STATS_INC
+
+#include <stdint.h>
+#include <stdio.h>
+#include <jack/jack.h>
+
+#include "clis.h"
+
+// process time histogram, each bucket is 5% of the period, the last one holds
+// the periods that took longer than the period
+#define CLIS_STATS_BUCKETS      21
+#define CLIS_STATS_BUCKET_LOAD  0.05
+
+// the dsp load of the client since it was opened
+typedef struct clis_stats {
+    uint64_t        periods;
+    uint64_t        buckets[CLIS_STATS_BUCKETS];
+    uint64_t        process_ns;     // time spent in the process callback
+    uint64_t        budget_ns;      // the length of those periods
+    float           max_load;       // worst period, 1 is the whole period
+    uint64_t        xruns;
+} clis_stats;
+
+clis_rc clis_stats_init(jack_client_t *client);
+void    clis_stats_begin(void);
+void    clis_stats_end(jack_nframes_t nframes);
+void    clis_stats_read(clis_stats *stats);
+void    clis_stats_report(const clis_stats *stats, FILE *file);
+clis_rc clis_stats_start(double interval);
+void    clis_stats_stop(void);
+
+#endif // CLIS_STATS_INC
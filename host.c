@@ -0,0 +1,200 @@
+#include <getopt.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <jack/jack.h>
+#include "OOPS/Inc/OOPS.h"
+
+#include "clis.h"
+#include "clis_patch.h"
+#include "clis_render.h"
+#include "clis_stats.h"
+
+clis_patch   patch;
+clis_context context = {
+    .params_length = 0,
+    .params = NULL,
+    .client = NULL
+};
+
+// helper to allow us to call clis_close with no arguments with 'atexit'
+static void
+cleanup() {
+    clis_close(&context);
+    clis_patch_free(&patch);
+}
+
+static float
+frandom(void)
+{
+    return (float)rand() / (float)(RAND_MAX);
+}
+
+static int
+set_sample_rate(jack_nframes_t nframes, void *arg)
+{
+    (void)arg;
+
+    OOPSSetSampleRate((float)nframes);
+
+    return 0;
+}
+
+static void
+usage(const char *name)
+{
+    fprintf(stderr, "Usage: %s [-n name] [-s server] [-P patch] [-j workers] "
+            "[-t] [-S seconds] [-r file [-l seconds]] [-c] [-C socket] ['gen name [-p] [-m mode] [-<param> value]...']...\n", name);
+}
+
+int main (int argc, char *argv[])
+{
+    char      *client_name = "host";
+    char      *server_name = NULL;
+    char      *patch_path = NULL;
+    long       workers = 1;
+    int        timings = 0;
+    char      *render_path = NULL;
+    double     render_seconds = 10;
+    char      *control_path = NULL;
+    bool       control_stdin = false;
+    double     stats_interval = 0;
+    int        opt;
+    clis_rc    rc = CLIS_OK;
+
+    atexit(&cleanup);
+
+    while ((opt = getopt(argc, argv, "n:s:P:j:tr:l:cC:S:")) != -1) {
+        switch (opt) {
+            case 'n': client_name = optarg;                         break;
+            case 's': server_name = optarg;                         break;
+            case 'P': patch_path = optarg;                          break;
+            case 'j': workers = strtol(optarg, NULL, 10);           break;
+            case 't': timings = 1;                                  break;
+            case 'r': render_path = optarg;                         break;
+            case 'l': render_seconds = strtod(optarg, NULL);        break;
+            case 'c': control_stdin = true;                         break;
+            case 'C': control_path = optarg;                        break;
+            case 'S': stats_interval = strtod(optarg, NULL);        break;
+            default: {
+                usage(argv[0]);
+                exit(EXIT_FAILURE);
+            }
+        }
+    }
+
+    if (patch_path) {
+        rc = clis_patch_load(&patch, patch_path);
+    }
+
+    for (; rc == CLIS_OK && optind < argc; optind++) {
+        // the spec is tokenised in place, keep a copy for the error message
+        char *spec = strdup(argv[optind]);
+
+        rc = clis_patch_add(&patch, argv[optind]);
+        if (rc) {
+            fprintf(stderr, "%s: ", spec ? spec : argv[optind]);
+        }
+        free(spec);
+    }
+
+    if (rc == CLIS_OK && (patch.nodes_length == 0 || workers < 1)) {
+        usage(argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    if (rc == CLIS_OK) {
+        rc = clis_patch_link(&patch);
+    }
+
+    if (rc) {
+        fprintf(stderr, "%s\n", clis_rc_string(rc));
+        exit(EXIT_FAILURE);
+    }
+
+    rc = clis_init_client(client_name, server_name, &context.client,
+                          clis_patch_process, &patch, set_sample_rate, NULL);
+    if(rc) {
+        fprintf(stderr, "%s", clis_rc_string(rc));
+        exit(EXIT_FAILURE);
+    }
+
+    srand((unsigned int)time(NULL));
+    OOPSInit((float)jack_get_sample_rate(context.client), &frandom);
+
+    rc = clis_patch_instantiate(&patch, context.client);
+    if(rc) {
+        fprintf(stderr, "%s", clis_rc_string(rc));
+        exit(EXIT_FAILURE);
+    }
+
+    rc = clis_patch_start(&patch, context.client, (size_t)workers);
+    if(rc) {
+        fprintf(stderr, "%s", clis_rc_string(rc));
+        exit(EXIT_FAILURE);
+    }
+
+    context.params          = patch.params;
+    context.params_length   = patch.params_length;
+    context.names           = (const char *const *)patch.names;
+    context.latency_cb      = clis_patch_latency;
+    context.latency_cb_arg  = &patch;
+
+    rc = clis_start(&context);
+    if(rc) {
+        fprintf(stderr, "%s", clis_rc_string(rc));
+        exit(EXIT_FAILURE);
+    }
+
+    if (control_stdin || control_path) {
+        rc = clis_control_start(&patch.control, context.client,
+                                patch.params, (const char *const *)patch.names,
+                                patch.params_length, control_stdin,
+                                control_path);
+        if (rc) {
+            fprintf(stderr, "%s\n", clis_rc_string(rc));
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    if (stats_interval > 0) {
+        rc = clis_stats_start(stats_interval);
+        if (rc) {
+            fprintf(stderr, "%s\n", clis_rc_string(rc));
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    rc = clis_patch_play(&patch, context.client);
+    if(rc) {
+        fprintf(stderr, "%s", clis_rc_string(rc));
+    }
+
+    if (render_path) {
+        rc = clis_render(context.client, render_path, render_seconds);
+        if (rc) {
+            fprintf(stderr, "%s: %s\n", render_path, clis_rc_string(rc));
+        }
+    } else {
+        clis_run();
+    }
+
+    if (timings) {
+        clis_patch_report(&patch, stdout);
+#if OOPS_PROFILE
+        OOPSProfileDump(stdout);
+#endif
+    }
+
+    if (stats_interval > 0) {
+        clis_stats stats;
+
+        clis_stats_read(&stats);
+        clis_stats_report(&stats, stdout);
+    }
+
+    printf("exiting gracefully\n");
+}
@@ -14,6 +14,15 @@
 #include "OOPSMemConfig.h"
 
 #include "OOPSMath.h"
+
+#if OOPS_PROFILE
+#include <stdatomic.h>
+#include <stdio.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#endif
 typedef struct _tCompressor
 {
     float tauAttack, tauRelease;
@@ -29,8 +38,10 @@ typedef struct _tCompressor
 
 typedef struct _tPhasor
 {
-    float phase;
-    float inc,freq;
+    // Phase and increment in 32 bit fractions of a turn, the phase wraps by overflowing
+    uint32_t phase;
+    uint32_t inc;
+    float freq;
     
     void (*sampleRateChanged)(struct _tPhasor *self);
     
@@ -40,46 +51,84 @@ typedef struct _tPhasor
 // Cycle: Sine waveform
 typedef struct _tCycle
 {
-    // Underlying phasor
-    float phase;
-    float inc,freq;
+    // Underlying phasor, in 32 bit fractions of a turn
+    uint32_t phase;
+    uint32_t inc;
+    float freq;
     
     void (*sampleRateChanged)(struct _tCycle *self);
     
 } tCycle;
 
-// Sawtooth waveform
-typedef struct _tSawtooth
+// Waves of the band limited oscillators
+typedef enum OscWave
 {
-    // Underlying phasor
-    float phase;
-    float inc,freq;
-    
-    void (*sampleRateChanged)(struct _tSawtooth *self);
-    
-} tSawtooth;
+    OscWaveSawtooth = 0,
+    OscWaveTriangle,
+    OscWaveSquare,
+    OscWaveNil
+} OscWave;
 
-// Triangle waveform
-typedef struct _tTriangle
+// How the band limited oscillators limit their band
+typedef enum OscMode
+{
+    OscModeWavetable = 0,   // mipmapped band limited tables
+    OscModePolyBLEP,        // naive wave with polynomial corrections at its steps and corners, no tables
+    OscModeNil
+} OscMode;
+
+// Band limited wavetable oscillator, the core of tSawtooth, tTriangle and tSquare
+typedef struct _tWavetable
 {
-    // Underlying phasor
-    float phase;
-    float inc,freq;
+    // Underlying phasor, in 32 bit fractions of a turn
+    uint32_t phase;
+    uint32_t inc;
+    float freq;
     
-    void (*sampleRateChanged)(struct _tTriangle *self);
+    OscWave wave;
+    OscMode mode;
     
-} tTriangle;
+    // Mipmapped tables of the wave, and the two bands mixed at freq with the log2 of their sizes and
+    // the weight of the lower one. SetFreq picks them so the Tick does not.
+    const float* bands;
+    const float* lower;
+    const float* upper;
+    int lowerBits, upperBits;
+    float w;
+    
+    void (*sampleRateChanged)(struct _tWavetable *self);
+    
+} tWavetable;
+
+// Sawtooth waveform
+typedef tWavetable tSawtooth;
+
+// Triangle waveform
+typedef tWavetable tTriangle;
 
 // Square waveform
-typedef struct _tSquare
+typedef tWavetable tSquare;
+
+// Sawtooth, triangle, square and sine from one phasor. The band limited waves share their band layout,
+// so one pick of the bands and one index into them serves all three.
+typedef struct _tMultiOsc
 {
-    // Underlying phasor
-    float phase;
-    float inc,freq;
+    // Underlying phasor, in 32 bit fractions of a turn
+    uint32_t phase;
+    uint32_t inc;
+    float freq;
+    
+    OscMode mode;
+    
+    // Offsets into each wave's tables of the two bands mixed at freq, the log2 of their sizes and the
+    // weight of the lower one.
+    int lower, upper;
+    int lowerBits, upperBits;
+    float w;
     
-    void (*sampleRateChanged)(struct _tSquare *self);
+    void (*sampleRateChanged)(struct _tMultiOsc *self);
     
-} tSquare;
+} tMultiOsc;
 
 // Noise Types
 typedef enum NoiseType
@@ -575,6 +624,7 @@ void     tCycleSampleRateChanged (tCycle *c);
 void     tSawtoothSampleRateChanged (tSawtooth *c);
 void     tTriangleSampleRateChanged (tTriangle *c);
 void     tSquareSampleRateChanged (tSquare *c);
+void     tMultiOscSampleRateChanged (tMultiOsc *c);
 void     tRampSampleRateChanged(tRamp *r);
 void     tTwoPoleSampleRateChanged (tTwoPole *c);
 void     tTwoZeroSampleRateChanged (tTwoZero *c);
@@ -603,6 +653,7 @@ typedef enum OOPSRegistryIndex
     T_SAWTOOTH,
     T_TRIANGLE,
     T_SQUARE,
+    T_MULTIOSC,
     T_NOISE,
     T_ONEPOLE,
     T_TWOPOLE,
@@ -636,6 +687,17 @@ typedef enum OOPSRegistryIndex
     T_INDEXCNT
 }OOPSRegistryIndex;
 
+#if OOPS_PROFILE
+// Cycles spent in the Tick of each component type and the number of Ticks, by OOPSRegistryIndex.
+// Only the thread that owns a set writes it, and sets start on a cache line of their own, so a Tick
+// adds to no line another thread writes.
+typedef struct _OOPSProfileCounters
+{
+    _Alignas(64) _Atomic uint64_t cycles[T_INDEXCNT];
+    _Atomic uint64_t ticks[T_INDEXCNT];
+} OOPSProfileCounters;
+#endif
+
 typedef struct _OOPS
 {
     float sampleRate, invSampleRate;
@@ -662,6 +724,10 @@ typedef struct _OOPS
     tSquare            tSquareRegistry          [N_SQUARE];
 #endif
         
+#if N_MULTIOSC
+    tMultiOsc          tMultiOscRegistry        [N_MULTIOSC];
+#endif
+        
 #if N_NOISE
     tNoise             tNoiseRegistry           [N_NOISE];
 #endif
@@ -787,9 +853,86 @@ typedef struct _OOPS
     
     
     int registryIndex[T_INDEXCNT];
+    
+#if OOPS_PROFILE
+    // A set of counters for each thread that has Ticked, summed by OOPSProfileDump. Threads beyond
+    // OOPS_PROFILE_THREADS share the last set.
+    OOPSProfileCounters profileThreads[OOPS_PROFILE_THREADS + 1];
+    atomic_int profileThreadsUsed;
+    // When profiling started, to convert cycles to time.
+    uint64_t profileStartCycles, profileStartNs;
+#endif
 		
 } OOPS;
 
 extern OOPS oops;
 
+#if OOPS_PROFILE
+
+void        OOPSProfileReset    (void);
+void        OOPSProfileDump     (FILE* file);
+
+// The counters of the calling thread, taken on its first Tick.
+extern _Thread_local OOPSProfileCounters* oopsProfileCounters;
+OOPSProfileCounters* OOPSProfileThread (void);
+
+// Time stamp counter, nanoseconds where there is none.
+static inline uint64_t OOPSProfileCycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+// Add n Ticks of a component type that took cycles to the counters of the calling thread.
+static inline void OOPSProfileCount(OOPSRegistryIndex type, uint64_t cycles, uint64_t n)
+{
+    OOPSProfileCounters* c = oopsProfileCounters;
+    
+    if (c == NULL) c = OOPSProfileThread();
+    
+    if (c == &oops.profileThreads[OOPS_PROFILE_THREADS])
+    {
+        // The shared set has more than one writer.
+        atomic_fetch_add_explicit(&c->cycles[type], cycles, memory_order_relaxed);
+        atomic_fetch_add_explicit(&c->ticks[type], n, memory_order_relaxed);
+        return;
+    }
+    
+    // The only writer, so a load and a store rather than a locked add, still safe for OOPSProfileDump to read.
+    atomic_store_explicit(&c->cycles[type], atomic_load_explicit(&c->cycles[type], memory_order_relaxed) + cycles, memory_order_relaxed);
+    atomic_store_explicit(&c->ticks[type], atomic_load_explicit(&c->ticks[type], memory_order_relaxed) + n, memory_order_relaxed);
+}
+
+// Count one Tick of a component type that started at start, and pass its output through.
+static inline float OOPSProfileTick(OOPSRegistryIndex type, uint64_t start, float out)
+{
+    OOPSProfileCount(type, OOPSProfileCycles() - start, 1);
+    return out;
+}
+
+// Count a block of n Ticks of a component type that started at start.
+static inline void OOPSProfileBlock(OOPSRegistryIndex type, uint64_t start, size_t n)
+{
+    OOPSProfileCount(type, OOPSProfileCycles() - start, n);
+}
+
+// Placed at the top of a Tick, and in place of its returns.
+#define OOPS_PROFILE_START()            uint64_t oopsProfileStart = OOPSProfileCycles()
+#define OOPS_PROFILE_RETURN(TYPE, OUT)  return OOPSProfileTick(TYPE, oopsProfileStart, (OUT))
+// Placed at the end of a TickBlock of N samples.
+#define OOPS_PROFILE_BLOCK(TYPE, N)     OOPSProfileBlock(TYPE, oopsProfileStart, (N))
+
+#else
+
+#define OOPS_PROFILE_START()
+#define OOPS_PROFILE_RETURN(TYPE, OUT)  return (OUT)
+#define OOPS_PROFILE_BLOCK(TYPE, N)
+
+#endif
+
 #endif  // CAUDIO_H_INCLUDED
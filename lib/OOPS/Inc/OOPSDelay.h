@@ -22,6 +22,7 @@ void     tDelayTapIn     (tDelay*  const, float in, uint32_t tapDelay);
 float    tDelayTapOut    (tDelay*  const, uint32_t tapDelay);
 float    tDelayAddTo     (tDelay*  const, float value, uint32_t tapDelay);
 float    tDelayTick      (tDelay*  const, float sample);
+void     tDelayTickBlock (tDelay*  const, const float* in, float* out, size_t numSamples);
 float    tDelayGetLastOut(tDelay*  const);
 float    tDelayGetLastIn (tDelay*  const);
 
@@ -33,6 +34,8 @@ void     tDelayLTapIn     (tDelayL*  const, float in, uint32_t tapDelay);
 float    tDelayLTapOut    (tDelayL*  const, uint32_t tapDelay);
 float    tDelayLAddTo     (tDelayL*  const, float value, uint32_t tapDelay);
 float    tDelayLTick      (tDelayL*  const, float sample);
+// delay, if not NULL, sets the delay in samples of each sample.
+void     tDelayLTickBlock (tDelayL*  const, const float* in, const float* delay, float* out, size_t numSamples);
 float    tDelayLGetLastOut(tDelayL*  const);
 float    tDelayLGetLastIn (tDelayL*  const);
 
@@ -44,6 +47,7 @@ void     tDelayATapIn     (tDelayA*  const, float in, uint32_t tapDelay);
 float    tDelayATapOut    (tDelayA*  const, uint32_t tapDelay);
 float    tDelayAAddTo     (tDelayA*  const, float value, uint32_t tapDelay);
 float    tDelayATick      (tDelayA*  const, float sample);
+void     tDelayATickBlock (tDelayA*  const, const float* in, float* out, size_t numSamples);
 float    tDelayAGetLastOut(tDelayA*  const);
 float    tDelayAGetLastIn (tDelayA*  const);
 
@@ -15,6 +15,7 @@
 
 tButterworth* tButterworthInit(int N, float f1, float f2);
 float tButterworthTick(tButterworth* const, float input);
+void tButterworthTickBlock(tButterworth* const, const float* in, float* out, size_t numSamples);
 
 void tButterworthSetF1(tButterworth* const, float in);
 void tButterworthSetF2(tButterworth* const, float in);
@@ -23,6 +24,7 @@ void tButterworthSetFreqs(tButterworth* const, float f1, float f2);
 /* tOnePole: OnePole filter, reimplemented from STK (Cook and Scavone). */
 tOnePole*   tOnePoleInit           (float thePole);
 float       tOnePoleTick           (tOnePole*  const, float input);
+void        tOnePoleTickBlock      (tOnePole*  const, const float* in, float* out, size_t numSamples);
 
 void        tOnePoleSetB0          (tOnePole*  const, float b0);
 void        tOnePoleSetA1          (tOnePole*  const, float a1);
@@ -33,6 +35,7 @@ void        tOnePoleSetGain        (tOnePole*  const, float gain);
 /* TwoPole filter, reimplemented from STK (Cook and Scavone). */
 tTwoPole*   tTwoPoleInit           (void);
 float       tTwoPoleTick           (tTwoPole*  const, float input);
+void        tTwoPoleTickBlock      (tTwoPole*  const, const float* in, float* out, size_t numSamples);
 
 void        tTwoPoleSetB0          (tTwoPole*  const, float b0);
 void        tTwoPoleSetA1          (tTwoPole*  const, float a1);
@@ -44,6 +47,7 @@ void        tTwoPoleSetGain        (tTwoPole*  const, float gain);
 /* OneZero filter, reimplemented from STK (Cook and Scavone). */
 tOneZero*   tOneZeroInit           (float theZero);
 float       tOneZeroTick           (tOneZero*  const, float input);
+void        tOneZeroTickBlock      (tOneZero*  const, const float* in, float* out, size_t numSamples);
 
 void        tOneZeroSetB0          (tOneZero*  const, float b0);
 void        tOneZeroSetB1          (tOneZero*  const, float b1);
@@ -55,6 +59,7 @@ float       tOneZeroGetPhaseDelay(tOneZero *f, float frequency );
 /* TwoZero filter, reimplemented from STK (Cook and Scavone). */
 tTwoZero*   tTwoZeroInit           (void);
 float       tTwoZeroTick           (tTwoZero*  const, float input);
+void        tTwoZeroTickBlock      (tTwoZero*  const, const float* in, float* out, size_t numSamples);
 
 void        tTwoZeroSetB0          (tTwoZero*  const, float b0);
 void        tTwoZeroSetB1          (tTwoZero*  const, float b1);
@@ -66,6 +71,7 @@ void        tTwoZeroSetGain        (tTwoZero*  const, float gain);
 /* PoleZero filter, reimplemented from STK (Cook and Scavone). */
 tPoleZero*  tPoleZeroInit              (void);
 float       tPoleZeroTick              (tPoleZero*  const, float input);
+void        tPoleZeroTickBlock         (tPoleZero*  const, const float* in, float* out, size_t numSamples);
 
 void        tPoleZeroSetB0             (tPoleZero*  const, float b0);
 void        tPoleZeroSetB1             (tPoleZero*  const, float b1);
@@ -78,6 +84,7 @@ void        tPoleZeroSetGain           (tPoleZero*  const, float gain);
 /* BiQuad filter, reimplemented from STK (Cook and Scavone). */
 tBiQuad*    tBiQuadInit           (void);
 float       tBiQuadTick           (tBiQuad*  const, float input);
+void        tBiQuadTickBlock       (tBiQuad*  const, const float* in, float* out, size_t numSamples);
 
 void        tBiQuadSetB0          (tBiQuad*  const, float b0);
 void        tBiQuadSetB1          (tBiQuad*  const, float b1);
@@ -92,6 +99,8 @@ void        tBiQuadSetGain        (tBiQuad*  const, float gain);
 /* State Variable Filter, algorithm from Andy Simper. */
 tSVF*       tSVFInit        (SVFType type, float freq, float Q);
 float       tSVFTick        (tSVF*  const, float v0);
+// Filter numSamples samples of in into out, which may be in. freq and Q, if not NULL, set them for each sample.
+void        tSVFTickBlock   (tSVF*  const, const float* in, const float* freq, const float* Q, float* out, size_t numSamples);
 
 int         tSVFSetFreq     (tSVF*  const, float freq);
 int         tSVFSetQ        (tSVF*  const, float Q);
@@ -99,6 +108,7 @@ int         tSVFSetQ        (tSVF*  const, float Q);
 /* Efficient State Variable Filter for 14-bit control input, [0, 4096). */
 tSVFE*      tSVFEInit       (SVFType type, uint16_t controlFreq, float Q);
 float       tSVFETick       (tSVFE*  const, float v0);
+void        tSVFETickBlock  (tSVFE*  const, const float* in, float* out, size_t numSamples);
 
 int         tSVFESetFreq    (tSVFE*  const, uint16_t controlFreq);
 int         tSVFESetQ       (tSVFE*  const, float Q);
@@ -106,6 +116,7 @@ int         tSVFESetQ       (tSVFE*  const, float Q);
 /* Simple Highpass filter. */
 tHighpass*  tHighpassInit      (float freq);
 float       tHighpassTick      (tHighpass*  const, float x);
+void        tHighpassTickBlock     (tHighpass*  const, const float* in, float* out, size_t numSamples);
 
 void        tHighpassSetFreq   (tHighpass*  const, float freq);
 float       tHighpassGetFreq   (tHighpass*  const);
@@ -17,6 +17,7 @@
 /* tTalkbox */
 tTalkbox*   tTalkboxInit        (void);
 float       tTalkboxTick        (tTalkbox* const, float synth, float voice);
+void        tTalkboxTickBlock   (tTalkbox* const, const float* synth, const float* voice, float* out, size_t numSamples);
 void        tTalkboxUpdate      (tTalkbox* const);
 void        tTalkboxSuspend     (tTalkbox* const);
 void        tTalkboxLpcDurbin   (float *r, int p, float *k, float *g);
@@ -27,12 +28,14 @@ void        tTalkboxLpc         (float *buf, float *car, int32_t n, int32_t o);
 /* tVocoder */
 tVocoder*   tVocoderInit        (void);
 float       tVocoderTick        (tVocoder* const, float synth, float voice);
+void        tVocoderTickBlock   (tVocoder* const, const float* synth, const float* voice, float* out, size_t numSamples);
 void        tVocoderUpdate      (tVocoder* const);
 void        tVocoderSuspend     (tVocoder* const);
 
 /* tPluck */
 tPluck*     tPluckInit          (float lowestFrequency, float delayBuff[DELAY_LENGTH]);
 float       tPluckTick          (tPluck*  const);
+void        tPluckTickBlock     (tPluck*  const, float* out, size_t numSamples);
 
 // Pluck the string.
 void        tPluckPluck         (tPluck*  const, float amplitude);
@@ -63,6 +66,7 @@ typedef enum SKControlType
 
 tStifKarp*  tStifKarpInit               (float lowestFrequency, float delayBuff[2][DELAY_LENGTH]);
 float       tStifKarpTick               (tStifKarp*  const);
+void        tStifKarpTickBlock          (tStifKarp*  const, float* out, size_t numSamples);
 
 // Pluck the string.
 void        tStifKarpPluck              (tStifKarp*  const, float amplitude);
@@ -67,6 +67,11 @@ typedef enum oBool
 #define TWO_TO_16 				65536.f
 #define INV_TWO_TO_15 		0.00001525878f
 #define TWO_TO_16_MINUS_ONE 65535.0f
+#define TWO_TO_24 				16777216.f
+#define INV_TWO_TO_24 		0.000000059604645f
+#define INV_TWO_TO_30 		0.00000000093132257f
+#define TWO_TO_32 				4294967296.f
+#define INV_TWO_TO_32 		0.00000000023283064f
 
 // Erbe shaper
 float OOPS_shaper     (float input, float m_drive);
@@ -19,9 +19,6 @@
  *                                                                                                       *
  * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 
-#define SHAPER1_TABLE_SIZE 65536
-extern const float shaper1[SHAPER1_TABLE_SIZE];
-
 // Arbitrary number of instances.
 #define NI 0
 
@@ -36,11 +33,12 @@ extern const float shaper1[SHAPER1_TABLE_SIZE];
 #define     N_STIFKARP          0
 #define     N_NEURON            0
 #define     N_PHASOR            0
-#define     N_CYCLE             1
-#define     N_SAWTOOTH          10
-#define     N_TRIANGLE          1
-#define     N_SQUARE            1
-#define     N_NOISE             1 + (1 * N_STIFKARP) + (1 * N_PLUCK) // StifKarp and Pluck each contain 1 Noise component.
+#define     N_CYCLE             64
+#define     N_SAWTOOTH          32
+#define     N_TRIANGLE          32
+#define     N_SQUARE            32
+#define     N_MULTIOSC          32
+#define     N_NOISE             16 + (1 * N_STIFKARP) + (1 * N_PLUCK) // StifKarp and Pluck each contain 1 Noise component.
 #define     N_ONEPOLE           0 + (1 * N_PLUCK)
 #define     N_TWOPOLE           0
 #define     N_ONEZERO           0 + (1 * N_STIFKARP) + (1 * N_PLUCK) + (1 * N_NEURON)
@@ -48,7 +46,7 @@ extern const float shaper1[SHAPER1_TABLE_SIZE];
 #define     N_TWOZERO           0
 #define     N_POLEZERO          0 + (1 * N_NEURON)
 #define     N_BIQUAD            0 + (4 * N_STIFKARP)
-#define     N_SVF               1 + 32*N_BUTTERWORTH
+#define     N_SVF               32 + 32*N_BUTTERWORTH
 #define     N_SVFE              0
 #define     N_HIGHPASS          0
 #define     N_DELAY             0 + (14 * N_NREV) + (3 * N_PRCREV)
@@ -60,7 +58,7 @@ extern const float shaper1[SHAPER1_TABLE_SIZE];
 #define     N_ENVELOPEFOLLOW    0
 #define     N_VOCODER           0
 #define     N_TALKBOX           1
-#define     N_POLYPHONICHANDLER 1
+#define     N_POLYPHONICHANDLER 8
 
 #define     DELAY_LENGTH        16000   // The maximum delay length of all Delay/DelayL/DelayA components.
                                             // Feel free to change to suit memory constraints or desired delay max length / functionality.
@@ -71,11 +69,18 @@ extern const float shaper1[SHAPER1_TABLE_SIZE];
 #define     INC_MISC_WT         0     // Set this to 1 if you are interested in the mtof1, adc1, tanh1, and shaper1 wavetables
                                         // and have spare memory.
 
+#ifndef OOPS_PROFILE
+#define     OOPS_PROFILE        0     // Set this to 1 (or build with -DOOPS_PROFILE=1) to count the cycles spent in the Tick
+                                        // of each component type, see OOPSProfileDump. Adds a timestamp to every Tick.
+#endif
+
+#define     OOPS_PROFILE_THREADS 32   // Threads that get counters of their own when profiling, any more share one set.
+
 // Preprocessor defines to determine whether to include component files in build.
 #define INC_UTILITIES       (N_ENVELOPE || N_ENVELOPEFOLLOW || N_RAMP || N_ADSR || N_COMPRESSOR || N_POLYPHONICHANDLER)
 #define INC_DELAY           (N_DELAY || N_DELAYL || N_DELAYA)
 #define INC_FILTER          (N_BUTTERWORTH || N_ONEPOLE || N_TWOPOLE || N_ONEZERO || N_TWOZERO || N_POLEZERO || N_BIQUAD || N_SVF || N_SVFE || N_HIGHPASS)
-#define INC_OSCILLATOR      (N_PHASOR || N_SAWTOOTH || N_CYCLE || N_TRIANGLE || N_SQUARE || N_NOISE)
+#define INC_OSCILLATOR      (N_PHASOR || N_SAWTOOTH || N_CYCLE || N_TRIANGLE || N_SQUARE || N_MULTIOSC || N_NOISE)
 #define INC_REVERB          (N_NREV || N_PRCREV)
 #define INC_INSTRUMENT      (N_STIFKARP || N_PLUCK || N_VOCODER || N_TALKBOX || N_808SNARE || N_808HIHAT || N_808COWBELL)
 
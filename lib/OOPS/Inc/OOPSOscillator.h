@@ -17,6 +17,7 @@
 tNeuron*    tNeuronInit(void);
 void        tNeuronReset(tNeuron* const);
 float       tNeuronTick(tNeuron* const);
+void        tNeuronTickBlock(tNeuron* const, float* out, size_t numSamples);
 void        tNeuronSetMode  (tNeuron* const, NeuronMode mode);
 void        tNeuronSetCurrent  (tNeuron* const, float current);
 void        tNeuronSetK(tNeuron* const, float K);
@@ -31,6 +32,8 @@ void        tNeuronSetTimeStep(tNeuron* const, float timestep);
 /* tCycle: Cycle/Sine waveform */
 tCycle*     tCycleInit         (void);
 float       tCycleTick         (tCycle*  const);
+// Render numSamples Ticks into out. freq, if not NULL, sets the frequency in Hz of each sample.
+void        tCycleTickBlock    (tCycle*  const, const float* freq, float* out, size_t numSamples);
 
 // Set frequency in Hz.
 int         tCycleSetFreq      (tCycle*  const, float freq);
@@ -39,6 +42,8 @@ int         tCycleSetFreq      (tCycle*  const, float freq);
 /* tPhasor: Aliasing phasor [0.0, 1.0) */
 tPhasor*    tPhasorInit        (void);
 float       tPhasorTick        (tPhasor*  const);
+// Render numSamples Ticks into out. freq, if not NULL, sets the frequency in Hz of each sample.
+void        tPhasorTickBlock   (tPhasor*  const, const float* freq, float* out, size_t numSamples);
 
 // Set frequency in Hz.
 int         tPhasorSetFreq     (tPhasor*  const, float freq);
@@ -47,6 +52,11 @@ int         tPhasorSetFreq     (tPhasor*  const, float freq);
 /* tSawtooth: Anti-aliased Sawtooth waveform using wavetable interpolation. Wavetables constructed from sine components. */
 tSawtooth*  tSawtoothInit      (void);
 float       tSawtoothTick      (tSawtooth*  const);
+// Render numSamples Ticks into out. freq, if not NULL, sets the frequency in Hz of each sample.
+void        tSawtoothTickBlock (tSawtooth*  const, const float* freq, float* out, size_t numSamples);
+
+// Band limit with the wavetables, the default, or with PolyBLEP which needs no tables.
+void        tSawtoothSetMode   (tSawtooth*  const, OscMode mode);
 
 // Set frequency in Hz.
 int         tSawtoothSetFreq   (tSawtooth*  const, float freq);
@@ -55,6 +65,11 @@ int         tSawtoothSetFreq   (tSawtooth*  const, float freq);
 /* tTriangle: Anti-aliased Triangle waveform using wavetable interpolation. Wavetables constructed from sine components. */
 tTriangle*  tTriangleInit      (void);
 float       tTriangleTick      (tTriangle*  const);
+// Render numSamples Ticks into out. freq, if not NULL, sets the frequency in Hz of each sample.
+void        tTriangleTickBlock (tTriangle*  const, const float* freq, float* out, size_t numSamples);
+
+// Band limit with the wavetables, the default, or with PolyBLEP which needs no tables.
+void        tTriangleSetMode   (tTriangle*  const, OscMode mode);
 
 // Set frequency in Hz.
 int         tTriangleSetFreq   (tTriangle*  const, float freq);
@@ -63,13 +78,33 @@ int         tTriangleSetFreq   (tTriangle*  const, float freq);
 /* tSquare: Anti-aliased Square waveform using wavetable interpolation. Wavetables constructed from sine components. */
 tSquare*    tSquareInit        (void);
 float       tSquareTick        (tSquare*  const);
+// Render numSamples Ticks into out. freq, if not NULL, sets the frequency in Hz of each sample.
+void        tSquareTickBlock   (tSquare*  const, const float* freq, float* out, size_t numSamples);
+
+// Band limit with the wavetables, the default, or with PolyBLEP which needs no tables.
+void        tSquareSetMode     (tSquare*  const, OscMode mode);
 
 // Set frequency in Hz.
 int         tSquareSetFreq     (tSquare*  const, float freq);
 
 
+/* tMultiOsc: Anti-aliased Sawtooth, Square and Triangle and a Sine, all read off one phasor with one pick of the wavetable bands. */
+tMultiOsc*  tMultiOscInit      (void);
+// One Tick of each wave into those of saw, sqr, tri and sine that are not NULL.
+void        tMultiOscTick      (tMultiOsc*  const, float* saw, float* sqr, float* tri, float* sine);
+// Render numSamples Ticks into those of saw, sqr, tri and sine that are not NULL. freq, if not NULL, sets the frequency in Hz of each sample.
+void        tMultiOscTickBlock (tMultiOsc*  const, const float* freq, float* saw, float* sqr, float* tri, float* sine, size_t numSamples);
+
+// Band limit the Sawtooth, Square and Triangle with the wavetables, the default, or with PolyBLEP which needs no tables.
+void        tMultiOscSetMode   (tMultiOsc*  const, OscMode mode);
+
+// Set frequency in Hz.
+int         tMultiOscSetFreq   (tMultiOsc*  const, float freq);
+
+
 /* tNoise. WhiteNoise, PinkNoise. */
 tNoise*     tNoiseInit         (NoiseType type);
 float       tNoiseTick         (tNoise*  const);
+void        tNoiseTickBlock    (tNoise*  const, float* out, size_t numSamples);
 
 #endif  // OOPSOSCILLATOR_H_INCLUDED
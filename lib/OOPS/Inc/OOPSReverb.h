@@ -17,6 +17,7 @@
 /* PRCRev: Reverb, reimplemented from STK (Cook and Scavone). */
 tPRCRev*    tPRCRevInit      (float t60);
 float       tPRCRevTick      (tPRCRev*  const, float input);
+void        tPRCRevTickBlock (tPRCRev*  const, const float* in, float* out, size_t numSamples);
 
 // Set reverb time in seconds.
 void        tPRCRevSetT60    (tPRCRev*  const, float t60);
@@ -27,6 +28,7 @@ void        tPRCRevSetMix    (tPRCRev*  const, float mix);
 /* NRev: Reverb, reimplemented from STK (Cook and Scavone). */
 tNRev*      tNRevInit   (float t60);
 float       tNRevTick   (tNRev*  const, float input);
+void        tNRevTickBlock(tNRev*  const, const float* in, float* out, size_t numSamples);
 
 // Set reverb time in seconds.
 void        tNRevSetT60 (tNRev*  const, float t60);
@@ -16,11 +16,13 @@
 
 tCompressor*            tCompressorInit    (void);
 float                   tCompressorTick    (tCompressor* const, float input);
+void                    tCompressorTickBlock(tCompressor* const, const float* in, float* out, size_t numSamples);
 
 
 /* Attack-Decay envelope */
 tEnvelope*              tEnvelopeInit      (float attack, float decay, oBool loop);
 float                   tEnvelopeTick      (tEnvelope*  const);
+void                    tEnvelopeTickBlock (tEnvelope*  const, float* out, size_t numSamples);
 
 int                     tEnvelopeSetAttack (tEnvelope*  const, float attack);
 
@@ -35,6 +37,7 @@ int                     tEnvelopeOn        (tEnvelope*  const, float velocity);
 /* Ramp */
 tRamp*                  tRampInit   (float time, int samplesPerTick);
 float                   tRampTick   (tRamp*  const);
+void                    tRampTickBlock(tRamp*  const, float* out, size_t numSamples);
 float 									tRampSample (tRamp*  const);
 
 int                     tRampSetTime(tRamp*  const, float time);
@@ -46,6 +49,7 @@ int                     tRampSetDest(tRamp*  const, float dest);
 /* Envelope Follower */
 tEnvelopeFollower*      tEnvelopeFollowerInit           (float attackThreshold, float decayCoeff);
 float                   tEnvelopeFollowerTick           (tEnvelopeFollower*  const, float x);
+void                    tEnvelopeFollowerTickBlock      (tEnvelopeFollower*  const, const float* in, float* out, size_t numSamples);
 
 int                     tEnvelopeFollowerDecayCoeff     (tEnvelopeFollower*  const, float decayCoeff);
 
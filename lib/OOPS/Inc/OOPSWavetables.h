@@ -19,9 +19,7 @@
 
 
 #define SINE_TABLE_SIZE 2048
-#define SAW_TABLE_SIZE 2048
-#define SQR_TABLE_SIZE 2048
-#define TRI_TABLE_SIZE 2048
+#define WAVETABLE_MIPMAP_SIZE 7051
 #define EXP_DECAY_TABLE_SIZE 65536
 #define ATTACK_DECAY_INC_TABLE_SIZE 65536
 #define TANH1_TABLE_SIZE 65536
@@ -45,40 +43,60 @@ typedef enum TableName
     TableNameNil
 } TableName;
 
+// Build the tables for sampleRate. OOPSInit calls this.
+void        OOPSWavetablesInit                  (float sampleRate);
+// Build the tables that depend on the sample rate again. OOPSSetSampleRate calls this when the rate changes.
+void        OOPSWavetablesSampleRateChanged     (float sampleRate);
+
 // mtof lookup table based on input range [0.0,1.0) in 4096 increments - midi frequency values scaled between m25 and m134 (as done in previous code)
 
 #if (N_ENVELOPE || N_ADSR)
-extern const float exp_decay[EXP_DECAY_TABLE_SIZE];
-extern const float attack_decay_inc[ATTACK_DECAY_INC_TABLE_SIZE];
+extern float exp_decay[EXP_DECAY_TABLE_SIZE];
+extern float attack_decay_inc[ATTACK_DECAY_INC_TABLE_SIZE];
 #endif
 
 #if (N_SVFE)
-extern const float filtertan[FILTERTAN_TABLE_SIZE];
+extern float filtertan[FILTERTAN_TABLE_SIZE];
 #endif
 
 #if INC_MISC_WT
+#define SHAPER1_TABLE_SIZE 65536
+extern const float shaper1[SHAPER1_TABLE_SIZE];
+
 extern const float mtof1[MTOF1_TABLE_SIZE];
 extern const float adc1[ADC1_TABLE_SIZE];
 
 extern const float tanh1[TANH1_TABLE_SIZE];
 #endif
 
-/* Sine wave table ripped from http://aquaticus.info/pwm-sine-wave. */
+/* One period of sine. */
 
 #if N_CYCLE
-extern const float sinewave[SINE_TABLE_SIZE];
+extern float sinewave[SINE_TABLE_SIZE];
+#endif
+
+/* Band limited saw, triangle and square waves, mipmapped. Band t of a wave holds wavetableSize[t] samples
+   from wavetableOffset[t], the higher bands have fewer harmonics so fewer samples. Each band is followed by a
+   copy of its first sample so an interpolated read past the last needs no wrap. The harmonics of a band are
+   those below Nyquist at the sample rate the tables were built for. The sizes are powers of two, wavetableBits
+   holds their log2. */
+
+#if N_SAWTOOTH || N_TRIANGLE || N_SQUARE || N_MULTIOSC
+extern const int wavetableSize[TableNameNil];
+extern const int wavetableBits[TableNameNil];
+extern const int wavetableOffset[TableNameNil];
 #endif
 
-#if N_SAWTOOTH
-extern const float sawtooth[11][SAW_TABLE_SIZE];
+#if N_SAWTOOTH || N_MULTIOSC
+extern float sawtooth[WAVETABLE_MIPMAP_SIZE];
 #endif
 
-#if N_TRIANGLE
-extern const float triangle[11][TRI_TABLE_SIZE];
+#if N_TRIANGLE || N_MULTIOSC
+extern float triangle[WAVETABLE_MIPMAP_SIZE];
 #endif
 
-#if N_SQUARE
-extern const float squarewave[11][SQR_TABLE_SIZE];
+#if N_SQUARE || N_MULTIOSC
+extern float squarewave[WAVETABLE_MIPMAP_SIZE];
 #endif
 
 #endif  // WAVETABLES_H_INCLUDED
@@ -11,10 +11,12 @@
 #if _WIN32 || _WIN64
 
 #include "..\Inc\OOPS.h"
+#include "..\Inc\OOPSWavetables.h"
 
 #else
 
 #include "../Inc/OOPS.h"
+#include "../Inc/OOPSWavetables.h"
 
 #endif
 
@@ -30,6 +32,12 @@ void OOPSInit(float sr, float(*random)(void))
     
     for (int i = 0; i < T_INDEXCNT; i++)
         oops.registryIndex[i] = 0;
+    
+    OOPSWavetablesInit(sr);
+    
+#if OOPS_PROFILE
+    OOPSProfileReset();
+#endif
 }
 
 
@@ -37,6 +45,9 @@ void OOPSInit(float sr, float(*random)(void))
 
 void OOPSSetSampleRate(float sampleRate)
 {
+    // JACK reports the rate it was opened at too, the tables are only built again for a new one.
+    if (sampleRate != oops.sampleRate) OOPSWavetablesSampleRateChanged(sampleRate);
+    
     oops.sampleRate = sampleRate;
     oops.invSampleRate = 1.0f/sampleRate;
     
@@ -61,6 +72,10 @@ void OOPSSetSampleRate(float sampleRate)
 		for (int i = 0; i < oops.registryIndex[T_SQUARE]; i++)         OOPSSampleRateChanged(tSquareRegistry[i]);
 #endif
     
+#if N_MULTIOSC 
+		for (int i = 0; i < oops.registryIndex[T_MULTIOSC]; i++)       OOPSSampleRateChanged(tMultiOscRegistry[i]);
+#endif
+    
 #if N_TWOPOLE 
 		for (int i = 0; i < oops.registryIndex[T_TWOPOLE]; i++)        OOPSSampleRateChanged(tTwoPoleRegistry[i]);
 #endif
@@ -119,3 +134,112 @@ float OOPSGetSampleRate()
     return oops.sampleRate;
 }
 
+#if OOPS_PROFILE
+
+static const char* profileNames[T_INDEXCNT] =
+{
+    [T_PHASOR]              = "tPhasor",
+    [T_CYCLE]               = "tCycle",
+    [T_SAWTOOTH]            = "tSawtooth",
+    [T_TRIANGLE]            = "tTriangle",
+    [T_SQUARE]              = "tSquare",
+    [T_MULTIOSC]            = "tMultiOsc",
+    [T_NOISE]               = "tNoise",
+    [T_ONEPOLE]             = "tOnePole",
+    [T_TWOPOLE]             = "tTwoPole",
+    [T_ONEZERO]             = "tOneZero",
+    [T_TWOZERO]             = "tTwoZero",
+    [T_POLEZERO]            = "tPoleZero",
+    [T_BIQUAD]              = "tBiQuad",
+    [T_SVF]                 = "tSVF",
+    [T_SVFE]                = "tSVFE",
+    [T_HIGHPASS]            = "tHighpass",
+    [T_DELAY]               = "tDelay",
+    [T_DELAYL]              = "tDelayL",
+    [T_DELAYA]              = "tDelayA",
+    [T_ENVELOPE]            = "tEnvelope",
+    [T_ADSR]                = "tADSR",
+    [T_RAMP]                = "tRamp",
+    [T_ENVELOPEFOLLOW]      = "tEnvelopeFollower",
+    [T_PRCREV]              = "tPRCRev",
+    [T_NREV]                = "tNRev",
+    [T_PLUCK]               = "tPluck",
+    [T_STIFKARP]            = "tStifKarp",
+    [T_NEURON]              = "tNeuron",
+    [T_COMPRESSOR]          = "tCompressor",
+    [T_BUTTERWORTH]         = "tButterworth",
+    [T_VOCODER]             = "tVocoder",
+    [T_TALKBOX]             = "tTalkbox",
+    [T_POLYPHONICHANDLER]   = "tPolyphonicHandler",
+    [T_808SNARE]            = "t808Snare",
+    [T_808HIHAT]            = "t808Hihat",
+    [T_808COWBELL]          = "t808Cowbell",
+};
+
+static uint64_t profileNs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+_Thread_local OOPSProfileCounters* oopsProfileCounters;
+
+// Takes the next free set of counters for the calling thread, or the shared set once they are all taken.
+// Sets are never given back, a thread that exits leaves its counts to be summed.
+OOPSProfileCounters* OOPSProfileThread(void)
+{
+    int i = atomic_fetch_add(&oops.profileThreadsUsed, 1);
+    
+    if (i >= OOPS_PROFILE_THREADS) i = OOPS_PROFILE_THREADS;
+    
+    return oopsProfileCounters = &oops.profileThreads[i];
+}
+
+// Counts of a thread that Ticks while this runs may survive it.
+void OOPSProfileReset(void)
+{
+    for (int t = 0; t <= OOPS_PROFILE_THREADS; t++)
+    {
+        for (int i = 0; i < T_INDEXCNT; i++)
+        {
+            atomic_store(&oops.profileThreads[t].cycles[i], 0);
+            atomic_store(&oops.profileThreads[t].ticks[i], 0);
+        }
+    }
+    
+    oops.profileStartCycles = OOPSProfileCycles();
+    oops.profileStartNs = profileNs();
+}
+
+// Prints the cost of a Tick of every component type that has been ticked since OOPSInit or OOPSProfileReset.
+// A Tick is one sample, the time of components used inside other components counts towards both.
+void OOPSProfileDump(FILE* file)
+{
+    uint64_t cycles = OOPSProfileCycles() - oops.profileStartCycles;
+    uint64_t ns = profileNs() - oops.profileStartNs;
+    double nsPerCycle = cycles ? (double)ns / (double)cycles : 0.0;
+    
+    fprintf(file, "%-20s %12s %12s %10s %10s\n", "component", "ticks", "cycles/tick", "ns/sample", "total ms");
+    
+    for (int i = 0; i < T_INDEXCNT; i++)
+    {
+        uint64_t ticks = 0, typeCycles = 0;
+        double perTick;
+        
+        for (int t = 0; t <= OOPS_PROFILE_THREADS; t++)
+        {
+            ticks += atomic_load(&oops.profileThreads[t].ticks[i]);
+            typeCycles += atomic_load(&oops.profileThreads[t].cycles[i]);
+        }
+        
+        if (ticks == 0) continue;
+        
+        perTick = (double)typeCycles / (double)ticks;
+        
+        fprintf(file, "%-20s %12llu %12.1f %10.2f %10.2f\n", profileNames[i], (unsigned long long)ticks,
+                perTick, perTick * nsPerCycle, perTick * nsPerCycle * (double)ticks / 1e6);
+    }
+}
+
+#endif
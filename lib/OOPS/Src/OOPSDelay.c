@@ -50,6 +50,8 @@ tDelay*    tDelayInit (uint32_t delay)
 
 float   tDelayTick (tDelay* const d, float input)
 {
+    OOPS_PROFILE_START();
+    
     // Input
     d->lastIn = input;
     d->buff[d->inPoint] = input * d->gain;
@@ -59,7 +61,33 @@ float   tDelayTick (tDelay* const d, float input)
     d->lastOut = d->buff[d->outPoint];
     if (++(d->outPoint) == d->maxDelay)    d->outPoint = 0;
     
-    return d->lastOut;
+    OOPS_PROFILE_RETURN(T_DELAY, d->lastOut);
+}
+
+void    tDelayTickBlock (tDelay* const d, const float* in, float* out, size_t numSamples)
+{
+    OOPS_PROFILE_START();
+    
+    float gain = d->gain, lastIn = d->lastIn, lastOut = d->lastOut;
+    uint32_t inPoint = d->inPoint, outPoint = d->outPoint, maxDelay = d->maxDelay;
+    
+    for (size_t i = 0; i < numSamples; i++)
+    {
+        lastIn = in[i];
+        d->buff[inPoint] = lastIn * gain;
+        if (++inPoint == maxDelay)     inPoint = 0;
+        
+        lastOut = d->buff[outPoint];
+        if (++outPoint == maxDelay)    outPoint = 0;
+        out[i] = lastOut;
+    }
+    
+    d->lastIn = lastIn;
+    d->lastOut = lastOut;
+    d->inPoint = inPoint;
+    d->outPoint = outPoint;
+    
+    OOPS_PROFILE_BLOCK(T_DELAY, numSamples);
 }
 
 
@@ -160,6 +188,8 @@ tDelayL*    tDelayLInit (float delay)
 
 float   tDelayLTick (tDelayL* const d, float input)
 {
+    OOPS_PROFILE_START();
+    
     d->buff[d->inPoint] = input * d->gain;
     
     // Increment input pointer modulo length.
@@ -178,7 +208,44 @@ float   tDelayLTick (tDelayL* const d, float input)
     // Increment output pointer modulo length.
     if ( ++(d->outPoint) == d->maxDelay )   d->outPoint = 0;
     
-    return d->lastOut;
+    OOPS_PROFILE_RETURN(T_DELAYL, d->lastOut);
+}
+
+void    tDelayLTickBlock (tDelayL* const d, const float* in, const float* delay, float* out, size_t numSamples)
+{
+    if (delay != NULL)
+    {
+        // Moving the read point is most of the work of a Tick, so a modulated delay is set and Ticked each sample.
+        for (size_t i = 0; i < numSamples; i++)
+        {
+            tDelayLSetDelay(d, delay[i]);
+            out[i] = tDelayLTick(d, in[i]);
+        }
+        return;
+    }
+    
+    OOPS_PROFILE_START();
+    
+    float gain = d->gain, alpha = d->alpha, omAlpha = d->omAlpha, lastOut = d->lastOut;
+    uint32_t inPoint = d->inPoint, outPoint = d->outPoint, maxDelay = d->maxDelay;
+    
+    for (size_t i = 0; i < numSamples; i++)
+    {
+        d->buff[inPoint] = in[i] * gain;
+        if (++inPoint == maxDelay)     inPoint = 0;
+        
+        lastOut = d->buff[outPoint] * omAlpha;
+        if (outPoint + 1 < maxDelay)    lastOut += d->buff[outPoint+1] * alpha;
+        else                            lastOut += d->buff[0] * alpha;
+        if (++outPoint == maxDelay)    outPoint = 0;
+        out[i] = lastOut;
+    }
+    
+    d->lastOut = lastOut;
+    d->inPoint = inPoint;
+    d->outPoint = outPoint;
+    
+    OOPS_PROFILE_BLOCK(T_DELAYL, numSamples);
 }
 
 int     tDelayLSetDelay (tDelayL* const d, float delay)
@@ -290,6 +357,8 @@ tDelayA*    tDelayAInit (float delay)
 
 float   tDelayATick (tDelayA* const d, float input)
 {
+    OOPS_PROFILE_START();
+    
     d->buff[d->inPoint] = input * d->gain;
     
     // Increment input pointer modulo length.
@@ -306,7 +375,35 @@ float   tDelayATick (tDelayA* const d, float input)
     // Increment output pointer modulo length.
     if (++(d->outPoint) >= d->maxDelay )   d->outPoint = 0;
     
-    return d->lastOut;
+    OOPS_PROFILE_RETURN(T_DELAYA, d->lastOut);
+}
+
+void    tDelayATickBlock (tDelayA* const d, const float* in, float* out, size_t numSamples)
+{
+    OOPS_PROFILE_START();
+    
+    float gain = d->gain, coeff = d->coeff, lastOut = d->lastOut, apInput = d->apInput;
+    uint32_t inPoint = d->inPoint, outPoint = d->outPoint, maxDelay = d->maxDelay;
+    
+    for (size_t i = 0; i < numSamples; i++)
+    {
+        d->buff[inPoint] = in[i] * gain;
+        if (++inPoint >= maxDelay)     inPoint = 0;
+        
+        float y = lastOut * -coeff;
+        y += apInput + ( coeff * d->buff[outPoint] );
+        lastOut = y;
+        apInput = d->buff[outPoint];
+        if (++outPoint >= maxDelay)    outPoint = 0;
+        out[i] = y;
+    }
+    
+    d->lastOut = lastOut;
+    d->apInput = apInput;
+    d->inPoint = inPoint;
+    d->outPoint = outPoint;
+    
+    OOPS_PROFILE_BLOCK(T_DELAYA, numSamples);
 }
 
 int     tDelayASetDelay (tDelayA* const d, float delay)
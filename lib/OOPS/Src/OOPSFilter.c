@@ -42,12 +42,30 @@ tButterworth* tButterworthInit(int N, float f1, float f2)
 
 float tButterworthTick(tButterworth* const f, float samp)
 {
+    OOPS_PROFILE_START();
+    
 	for(int i = 0; i < ((f->N)/2); ++i)
 	{
 		samp = tSVFTick(f->low[i],samp);
 		samp = tSVFTick(f->high[i],samp);
 	}
-	return samp;
+	OOPS_PROFILE_RETURN(T_BUTTERWORTH, samp);
+}
+
+void tButterworthTickBlock(tButterworth* const f, const float* in, float* out, size_t numSamples)
+{
+    OOPS_PROFILE_START();
+    
+    if (out != in)  for (size_t i = 0; i < numSamples; i++)   out[i] = in[i];
+    
+    // Each section runs over the whole block in turn, the order the samples see them in is unchanged.
+	for(int i = 0; i < ((f->N)/2); ++i)
+	{
+		tSVFTickBlock(f->low[i], out, NULL, NULL, out, numSamples);
+		tSVFTickBlock(f->high[i], out, NULL, NULL, out, numSamples);
+	}
+    
+    OOPS_PROFILE_BLOCK(T_BUTTERWORTH, numSamples);
 }
 
 void tButterworthSetF1(tButterworth* const f, float f1)
@@ -91,12 +109,32 @@ tOneZero*    tOneZeroInit(float theZero)
 
 float   tOneZeroTick(tOneZero* const f, float input)
 {
+    OOPS_PROFILE_START();
+    
     float in = input * f->gain;
     float out = f->b1 * f->lastIn + f->b0 * in;
     
     f->lastIn = in;
     
-    return out;
+    OOPS_PROFILE_RETURN(T_ONEZERO, out);
+}
+
+void    tOneZeroTickBlock(tOneZero* const f, const float* in, float* out, size_t numSamples)
+{
+    OOPS_PROFILE_START();
+    
+    float gain = f->gain, b0 = f->b0, b1 = f->b1, lastIn = f->lastIn;
+    
+    for (size_t i = 0; i < numSamples; i++)
+    {
+        float x = in[i] * gain;
+        out[i] = b1 * lastIn + b0 * x;
+        lastIn = x;
+    }
+    
+    f->lastIn = lastIn;
+    
+    OOPS_PROFILE_BLOCK(T_ONEZERO, numSamples);
 }
 
 void    tOneZeroSetZero(tOneZero* const f, float theZero)
@@ -174,13 +212,36 @@ tTwoZero*    tTwoZeroInit(void)
 
 float   tTwoZeroTick(tTwoZero* const f, float input)
 {
+    OOPS_PROFILE_START();
+    
     float in = input * f->gain;
     float out = f->b2 * f->lastIn[1] + f->b1 * f->lastIn[0] + f->b0 * in;
     
     f->lastIn[1] = f->lastIn[0];
     f->lastIn[0] = in;
     
-    return out;
+    OOPS_PROFILE_RETURN(T_TWOZERO, out);
+}
+
+void    tTwoZeroTickBlock(tTwoZero* const f, const float* in, float* out, size_t numSamples)
+{
+    OOPS_PROFILE_START();
+    
+    float gain = f->gain, b0 = f->b0, b1 = f->b1, b2 = f->b2;
+    float lastIn0 = f->lastIn[0], lastIn1 = f->lastIn[1];
+    
+    for (size_t i = 0; i < numSamples; i++)
+    {
+        float x = in[i] * gain;
+        out[i] = b2 * lastIn1 + b1 * lastIn0 + b0 * x;
+        lastIn1 = lastIn0;
+        lastIn0 = x;
+    }
+    
+    f->lastIn[0] = lastIn0;
+    f->lastIn[1] = lastIn1;
+    
+    OOPS_PROFILE_BLOCK(T_TWOZERO, numSamples);
 }
 
 void    tTwoZeroSetNotch(tTwoZero* const f, float freq, float radius)
@@ -289,13 +350,34 @@ void    tOnePoleSetGain(tOnePole* const f, float gain)
 
 float   tOnePoleTick(tOnePole* const f, float input)
 {
+    OOPS_PROFILE_START();
+    
     float in = input * f->gain;
     float out = (f->b0 * in) - (f->a1 * f->lastOut);
     
     f->lastIn = in;
     f->lastOut = out;
     
-    return out;
+    OOPS_PROFILE_RETURN(T_ONEPOLE, out);
+}
+
+void    tOnePoleTickBlock(tOnePole* const f, const float* in, float* out, size_t numSamples)
+{
+    OOPS_PROFILE_START();
+    
+    float gain = f->gain, b0 = f->b0, a1 = f->a1, lastIn = f->lastIn, lastOut = f->lastOut;
+    
+    for (size_t i = 0; i < numSamples; i++)
+    {
+        lastIn = in[i] * gain;
+        lastOut = (b0 * lastIn) - (a1 * lastOut);
+        out[i] = lastOut;
+    }
+    
+    f->lastIn = lastIn;
+    f->lastOut = lastOut;
+    
+    OOPS_PROFILE_BLOCK(T_ONEPOLE, numSamples);
 }
 #endif
 
@@ -320,13 +402,36 @@ tTwoPole*    tTwoPoleInit(void)
 
 float   tTwoPoleTick(tTwoPole* const f, float input)
 {
+    OOPS_PROFILE_START();
+    
     float in = input * f->gain;
     float out = (f->b0 * in) - (f->a1 * f->lastOut[0]) - (f->a2 * f->lastOut[1]);
     
     f->lastOut[1] = f->lastOut[0];
     f->lastOut[0] = out;
     
-    return out;
+    OOPS_PROFILE_RETURN(T_TWOPOLE, out);
+}
+
+void    tTwoPoleTickBlock(tTwoPole* const f, const float* in, float* out, size_t numSamples)
+{
+    OOPS_PROFILE_START();
+    
+    float gain = f->gain, b0 = f->b0, a1 = f->a1, a2 = f->a2;
+    float lastOut0 = f->lastOut[0], lastOut1 = f->lastOut[1];
+    
+    for (size_t i = 0; i < numSamples; i++)
+    {
+        float y = (b0 * (in[i] * gain)) - (a1 * lastOut0) - (a2 * lastOut1);
+        lastOut1 = lastOut0;
+        lastOut0 = y;
+        out[i] = y;
+    }
+    
+    f->lastOut[0] = lastOut0;
+    f->lastOut[1] = lastOut1;
+    
+    OOPS_PROFILE_BLOCK(T_TWOPOLE, numSamples);
 }
 
 void    tTwoPoleSetB0(tTwoPole* const f, float b0)
@@ -475,13 +580,36 @@ void    tPoleZeroSetGain(tPoleZero* const pzf, float gain)
 
 float   tPoleZeroTick(tPoleZero* const pzf, float input)
 {
+    OOPS_PROFILE_START();
+    
     float in = input * pzf->gain;
     float out = (pzf->b0 * in) + (pzf->b1 * pzf->lastIn) - (pzf->a1 * pzf->lastOut);
     
     pzf->lastIn = in;
     pzf->lastOut = out;
     
-    return out;
+    OOPS_PROFILE_RETURN(T_POLEZERO, out);
+}
+
+void    tPoleZeroTickBlock(tPoleZero* const pzf, const float* in, float* out, size_t numSamples)
+{
+    OOPS_PROFILE_START();
+    
+    float gain = pzf->gain, b0 = pzf->b0, b1 = pzf->b1, a1 = pzf->a1;
+    float lastIn = pzf->lastIn, lastOut = pzf->lastOut;
+    
+    for (size_t i = 0; i < numSamples; i++)
+    {
+        float x = in[i] * gain;
+        lastOut = (b0 * x) + (b1 * lastIn) - (a1 * lastOut);
+        lastIn = x;
+        out[i] = lastOut;
+    }
+    
+    pzf->lastIn = lastIn;
+    pzf->lastOut = lastOut;
+    
+    OOPS_PROFILE_BLOCK(T_POLEZERO, numSamples);
 }
 #endif
 
@@ -508,6 +636,8 @@ tBiQuad*    tBiQuadInit(void)
 
 float   tBiQuadTick(tBiQuad* const f, float input)
 {
+    OOPS_PROFILE_START();
+    
     float in = input * f->gain;
     float out = f->b0 * in + f->b1 * f->lastIn[0] + f->b2 * f->lastIn[1];
     out -= f->a2 * f->lastOut[1] + f->a1 * f->lastOut[0];
@@ -518,7 +648,36 @@ float   tBiQuadTick(tBiQuad* const f, float input)
     f->lastOut[1] = f->lastOut[0];
     f->lastOut[0] = out;
     
-    return out;
+    OOPS_PROFILE_RETURN(T_BIQUAD, out);
+}
+
+void    tBiQuadTickBlock(tBiQuad* const f, const float* in, float* out, size_t numSamples)
+{
+    OOPS_PROFILE_START();
+    
+    float gain = f->gain, b0 = f->b0, b1 = f->b1, b2 = f->b2, a1 = f->a1, a2 = f->a2;
+    float lastIn0 = f->lastIn[0], lastIn1 = f->lastIn[1];
+    float lastOut0 = f->lastOut[0], lastOut1 = f->lastOut[1];
+    
+    for (size_t i = 0; i < numSamples; i++)
+    {
+        float x = in[i] * gain;
+        float y = b0 * x + b1 * lastIn0 + b2 * lastIn1;
+        y -= a2 * lastOut1 + a1 * lastOut0;
+        
+        lastIn1 = lastIn0;
+        lastIn0 = x;
+        lastOut1 = lastOut0;
+        lastOut0 = y;
+        out[i] = y;
+    }
+    
+    f->lastIn[0] = lastIn0;
+    f->lastIn[1] = lastIn1;
+    f->lastOut[0] = lastOut0;
+    f->lastOut[1] = lastOut1;
+    
+    OOPS_PROFILE_BLOCK(T_BIQUAD, numSamples);
 }
 
 void    tBiQuadSetResonance(tBiQuad* const f, float freq, float radius, oBool normalize)
@@ -632,9 +791,31 @@ float     tHighpassGetFreq(tHighpass* const f)
 // From JOS DC Blocker
 float   tHighpassTick(tHighpass* const f, float x)
 {
+    OOPS_PROFILE_START();
+    
     f->ys = x - f->xs + f->R * f->ys;
     f->xs = x;
-    return f->ys;
+    OOPS_PROFILE_RETURN(T_HIGHPASS, f->ys);
+}
+
+void    tHighpassTickBlock(tHighpass* const f, const float* in, float* out, size_t numSamples)
+{
+    OOPS_PROFILE_START();
+    
+    float R = f->R, xs = f->xs, ys = f->ys;
+    
+    for (size_t i = 0; i < numSamples; i++)
+    {
+        float x = in[i];
+        ys = x - xs + R * ys;
+        xs = x;
+        out[i] = ys;
+    }
+    
+    f->xs = xs;
+    f->ys = ys;
+    
+    OOPS_PROFILE_BLOCK(T_HIGHPASS, numSamples);
 }
 
 tHighpass*    tHighpassInit(float freq)
@@ -661,6 +842,8 @@ void tHighpassSampleRateChanged(tHighpass* const f)
 #if N_SVF
 float   tSVFTick(tSVF* const svf, float v0)
 {
+    OOPS_PROFILE_START();
+    
     float v1,v2,v3;
     v3 = v0 - svf->ic2eq;
     v1 = (svf->a1 * svf->ic1eq) + (svf->a2 * v3);
@@ -668,19 +851,67 @@ float   tSVFTick(tSVF* const svf, float v0)
     svf->ic1eq = (2.0f * v1) - svf->ic1eq;
     svf->ic2eq = (2.0f * v2) - svf->ic2eq;
     
-    if (svf->type == SVFTypeLowpass)        return v2;
-    else if (svf->type == SVFTypeBandpass)  return v1;
-    else if (svf->type == SVFTypeHighpass)  return v0 - (svf->k * v1) - v2;
-    else if (svf->type == SVFTypeNotch)     return v0 - (svf->k * v1);
-    else if (svf->type == SVFTypePeak)      return v0 - (svf->k * v1) - (2.0f * v2);
-    else                                    return 0.0f;
+    if (svf->type == SVFTypeLowpass)        OOPS_PROFILE_RETURN(T_SVF, v2);
+    else if (svf->type == SVFTypeBandpass)  OOPS_PROFILE_RETURN(T_SVF, v1);
+    else if (svf->type == SVFTypeHighpass)  OOPS_PROFILE_RETURN(T_SVF, v0 - (svf->k * v1) - v2);
+    else if (svf->type == SVFTypeNotch)     OOPS_PROFILE_RETURN(T_SVF, v0 - (svf->k * v1));
+    else if (svf->type == SVFTypePeak)      OOPS_PROFILE_RETURN(T_SVF, v0 - (svf->k * v1) - (2.0f * v2));
+    else                                    OOPS_PROFILE_RETURN(T_SVF, 0.0f);
+    
+}
+
+void    tSVFTickBlock(tSVF* const svf, const float* in, const float* freq, const float* Q, float* out, size_t numSamples)
+{
+    OOPS_PROFILE_START();
+    
+    SVFType type = svf->type;
+    float g = svf->g, k = svf->k, a1 = svf->a1, a2 = svf->a2, a3 = svf->a3;
+    float ic1eq = svf->ic1eq, ic2eq = svf->ic2eq;
+    
+    for (size_t i = 0; i < numSamples; i++)
+    {
+        // The same as tSVFSetFreq and tSVFSetQ before each Tick.
+        if (freq != NULL)   g = tanf(PI * freq[i] * oops.invSampleRate);
+        if (Q != NULL)      k = 1.0f/OOPS_clip(0.01f,Q[i],10.0f);
+        if (freq != NULL || Q != NULL)
+        {
+            a1 = 1.0f/(1.0f + g * (g + k));
+            a2 = g * a1;
+            a3 = g * a2;
+        }
+        
+        float v0 = in[i], v1, v2, v3;
+        v3 = v0 - ic2eq;
+        v1 = (a1 * ic1eq) + (a2 * v3);
+        v2 = ic2eq + (a2 * ic1eq) + (a3 * v3);
+        ic1eq = (2.0f * v1) - ic1eq;
+        ic2eq = (2.0f * v2) - ic2eq;
+        
+        if (type == SVFTypeLowpass)         out[i] = v2;
+        else if (type == SVFTypeBandpass)   out[i] = v1;
+        else if (type == SVFTypeHighpass)   out[i] = v0 - (k * v1) - v2;
+        else if (type == SVFTypeNotch)      out[i] = v0 - (k * v1);
+        else if (type == SVFTypePeak)       out[i] = v0 - (k * v1) - (2.0f * v2);
+        else                                out[i] = 0.0f;
+    }
+    
+    svf->g = g;
+    svf->k = k;
+    svf->a1 = a1;
+    svf->a2 = a2;
+    svf->a3 = a3;
+    svf->ic1eq = ic1eq;
+    svf->ic2eq = ic2eq;
     
+    OOPS_PROFILE_BLOCK(T_SVF, numSamples);
 }
 
 // Less efficient, more accurate version of SVF, in which cutoff frequency is taken as floating point Hz value and tanh
 // is calculated when frequency changes.
 tSVF*    tSVFInit(SVFType type, float freq, float Q)
 {
+    if (oops.registryIndex[T_SVF] >= N_SVF) return NULL;
+    
     tSVF* svf = &oops.tSVFRegistry[oops.registryIndex[T_SVF]++];
     
     svf->type = type;
@@ -755,6 +986,8 @@ tSVFE*    tSVFEInit(SVFType type, uint16_t input, float Q)
 
 float   tSVFETick(tSVFE* const svf, float v0)
 {
+    OOPS_PROFILE_START();
+    
     float v1,v2,v3;
     v3 = v0 - svf->ic2eq;
     v1 = (svf->a1 * svf->ic1eq) + (svf->a2 * v3);
@@ -762,13 +995,44 @@ float   tSVFETick(tSVFE* const svf, float v0)
     svf->ic1eq = (2.0f * v1) - svf->ic1eq;
     svf->ic2eq = (2.0f * v2) - svf->ic2eq;
     
-    if (svf->type == SVFTypeLowpass)        return v2;
-    else if (svf->type == SVFTypeBandpass)  return v1;
-    else if (svf->type == SVFTypeHighpass)  return v0 - (svf->k * v1) - v2;
-    else if (svf->type == SVFTypeNotch)     return v0 - (svf->k * v1);
-    else if (svf->type == SVFTypePeak)      return v0 - (svf->k * v1) - (2.0f * v2);
-    else                                    return 0.0f;
+    if (svf->type == SVFTypeLowpass)        OOPS_PROFILE_RETURN(T_SVFE, v2);
+    else if (svf->type == SVFTypeBandpass)  OOPS_PROFILE_RETURN(T_SVFE, v1);
+    else if (svf->type == SVFTypeHighpass)  OOPS_PROFILE_RETURN(T_SVFE, v0 - (svf->k * v1) - v2);
+    else if (svf->type == SVFTypeNotch)     OOPS_PROFILE_RETURN(T_SVFE, v0 - (svf->k * v1));
+    else if (svf->type == SVFTypePeak)      OOPS_PROFILE_RETURN(T_SVFE, v0 - (svf->k * v1) - (2.0f * v2));
+    else                                    OOPS_PROFILE_RETURN(T_SVFE, 0.0f);
+    
+}
+
+void    tSVFETickBlock(tSVFE* const svf, const float* in, float* out, size_t numSamples)
+{
+    OOPS_PROFILE_START();
+    
+    SVFType type = svf->type;
+    float k = svf->k, a1 = svf->a1, a2 = svf->a2, a3 = svf->a3;
+    float ic1eq = svf->ic1eq, ic2eq = svf->ic2eq;
+    
+    for (size_t i = 0; i < numSamples; i++)
+    {
+        float v0 = in[i], v1, v2, v3;
+        v3 = v0 - ic2eq;
+        v1 = (a1 * ic1eq) + (a2 * v3);
+        v2 = ic2eq + (a2 * ic1eq) + (a3 * v3);
+        ic1eq = (2.0f * v1) - ic1eq;
+        ic2eq = (2.0f * v2) - ic2eq;
+        
+        if (type == SVFTypeLowpass)         out[i] = v2;
+        else if (type == SVFTypeBandpass)   out[i] = v1;
+        else if (type == SVFTypeHighpass)   out[i] = v0 - (k * v1) - v2;
+        else if (type == SVFTypeNotch)      out[i] = v0 - (k * v1);
+        else if (type == SVFTypePeak)       out[i] = v0 - (k * v1) - (2.0f * v2);
+        else                                out[i] = 0.0f;
+    }
+    
+    svf->ic1eq = ic1eq;
+    svf->ic2eq = ic2eq;
     
+    OOPS_PROFILE_BLOCK(T_SVFE, numSamples);
 }
 
 int     tSVFESetFreq(tSVFE* const svf, uint16_t input)
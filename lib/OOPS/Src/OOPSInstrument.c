@@ -157,6 +157,8 @@ void tTalkboxLpcDurbin(float *r, int p, float *k, float *g)
 
 float tTalkboxTick(tTalkbox* const v, float synth, float voice)
 {
+    OOPS_PROFILE_START();
+    
 
     int32_t  p0=v->pos, p1 = (v->pos + v->N/2) % v->N;
     float e=v->emphasis, w, o, x, dr, fx=v->FX;
@@ -207,7 +209,13 @@ float tTalkboxTick(tTalkbox* const v, float synth, float voice)
     if(fabs(v->u1) < den) v->u1 = 0.0f;
     if(fabs(v->u2) < den) v->u2 = 0.0f;
     if(fabs(v->u3) < den) v->u3 = 0.0f;
-    return o;
+    OOPS_PROFILE_RETURN(T_TALKBOX, o);
+}
+
+void tTalkboxTickBlock(tTalkbox* const v, const float* synth, const float* voice, float* out, size_t numSamples)
+{
+    // The analysis runs on windows that do not line up with blocks, so this is the Tick in a loop.
+    for (size_t i = 0; i < numSamples; i++)   out[i] = tTalkboxTick(v, synth[i], voice[i]);
 }
 
 #endif
@@ -318,6 +326,8 @@ void        tVocoderUpdate      (tVocoder* const v)
 
 float       tVocoderTick        (tVocoder* const v, float synth, float voice)
 {
+    OOPS_PROFILE_START();
+    
     float a, b, o=0.0f, aa, bb, oo = v->kout, g = v->gain, ht = v->thru, hh = v->high, tmp;
     uint32_t i, k = v->kval, sw = v->swap, nb = v->nbnd;
 
@@ -377,10 +387,16 @@ float       tVocoderTick        (tVocoder* const v, float synth, float voice)
     
     if(fabs(o)>10.0f) tVocoderSuspend(v); //catch instability
     
-    return o;
+    OOPS_PROFILE_RETURN(T_VOCODER, o);
     
 }
 
+void        tVocoderTickBlock   (tVocoder* const v, const float* synth, const float* voice, float* out, size_t numSamples)
+{
+    // The envelopes are decimated on a counter that does not line up with blocks, so this is the Tick in a loop.
+    for (size_t i = 0; i < numSamples; i++)   out[i] = tVocoderTick(v, synth[i], voice[i]);
+}
+
 void        tVocoderSuspend     (tVocoder* const v)
 {
     int32_t i, j;
@@ -423,7 +439,15 @@ float   tPluckGetLastOut    (tPluck *p)
 
 float   tPluckTick          (tPluck *p)
 {
-    return (p->lastOut = 3.0f * tDelayATick(p->delayLine, tOneZeroTick(p->loopFilter, tDelayAGetLastOut(p->delayLine) * p->loopGain ) ));
+    OOPS_PROFILE_START();
+    
+    OOPS_PROFILE_RETURN(T_PLUCK, (p->lastOut = 3.0f * tDelayATick(p->delayLine, tOneZeroTick(p->loopFilter, tDelayAGetLastOut(p->delayLine) * p->loopGain ) )));
+}
+
+void    tPluckTickBlock     (tPluck* const p, float* out, size_t numSamples)
+{
+    // The string feeds back through its delay every sample, so this is the Tick in a loop.
+    for (size_t i = 0; i < numSamples; i++)   out[i] = tPluckTick(p);
 }
 
 void    tPluckPluck         (tPluck* const p, float amplitude)
@@ -526,6 +550,8 @@ float   tStifKarpGetLastOut    (tStifKarp* const p)
 
 float   tStifKarpTick          (tStifKarp* const p)
 {
+    OOPS_PROFILE_START();
+    
     float temp = tDelayAGetLastOut(p->delayLine) * p->loopGain;
     
     // Calculate allpass stretching.
@@ -538,7 +564,13 @@ float   tStifKarpTick          (tStifKarp* const p)
     out = out - tDelayLTick(p->combDelay, out);
     p->lastOut = out;
     
-    return p->lastOut;
+    OOPS_PROFILE_RETURN(T_STIFKARP, p->lastOut);
+}
+
+void    tStifKarpTickBlock     (tStifKarp* const p, float* out, size_t numSamples)
+{
+    // The string feeds back through its delay every sample, so this is the Tick in a loop.
+    for (size_t i = 0; i < numSamples; i++)   out[i] = tStifKarpTick(p);
 }
 
 void    tStifKarpPluck         (tStifKarp* const p, float amplitude)
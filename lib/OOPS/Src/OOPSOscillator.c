@@ -22,6 +22,20 @@
 
 #endif
 
+// Phases are 32 bit fractions of a turn, so they wrap by overflowing. A table of 2^bits samples is indexed by the top
+// bits of a phase and interpolated by the bits below them.
+
+// The phase increment of freq.
+static inline uint32_t tPhaseInc(float freq)
+{
+    return (uint32_t)(int64_t)(freq * (oops.invSampleRate * TWO_TO_32));
+}
+
+// The phase in [0, 1), to the 24 bits a float holds.
+static inline float tPhaseFloat(uint32_t phase)
+{
+    return (float)(int32_t)(phase >> 8) * INV_TWO_TO_24;
+}
 
 #if N_NEURON
 
@@ -137,6 +151,8 @@ void        tNeuronSetC(tNeuron* const n, float C)
 
 float   tNeuronTick(tNeuron* const n)
 {
+    OOPS_PROFILE_START();
+    
     float output = 0.0f;
     float voltage = n->voltage;
     
@@ -205,10 +221,16 @@ float   tNeuronTick(tNeuron* const n)
     
     output = tPoleZeroTick(n->f, output);
     
-    return output;
+    OOPS_PROFILE_RETURN(T_NEURON, output);
 
 }
 
+void    tNeuronTickBlock(tNeuron* const n, float* out, size_t numSamples)
+{
+    // The membrane model needs every intermediate, so this is the Tick in a loop.
+    for (size_t i = 0; i < numSamples; i++)   out[i] = tNeuronTick(n);
+}
+
 void        tNeuronSetMode  (tNeuron* const n, NeuronMode mode)
 {
     n->mode = mode;
@@ -222,14 +244,86 @@ void        tNeuronSetCurrent  (tNeuron* const n, float current)
 #endif
 
 
+#if N_CYCLE || N_MULTIOSC
+// Sine of a phase by polynomial, no table. Shifted a quarter turn on, the phase folds into t, a
+// triangle from -1 at three quarters of a turn to 1 at a quarter, and sin(2 pi phase) is
+// sin(pi/2 t), which an odd minimax polynomial fits to 4e-9 on [-1, 1], below float rounding.
+// The interpolated sinewave table was out by up to 1.3e-6.
+static inline float tCycleSine(uint32_t phase)
+{
+    uint32_t u = phase + 0x40000000u;
+    uint32_t a = u ^ (uint32_t)((int32_t)u >> 31);
+    float t = (float)(int32_t)(a - 0x40000000u) * INV_TWO_TO_30;
+    float t2 = t * t;
+    
+    return t * (1.57079629f + t2 * (-0.64596336f + t2 * (0.0796884805f + t2 * (-0.00467222792f + t2 * 0.000150820565f))));
+}
+
+#define CYCLE_CHUNK 64 // phases a TickBlock gathers before computing their sines
+
+// Each sine is computed alone, branch free, so the compiler vectorizes this. On x86 it is also
+// built for AVX2, twice as wide as the SSE2 it can assume, and used when the CPU has it.
+#if defined(__x86_64__) && defined(__GNUC__)
+#define CYCLE_AVX2 1
+#else
+#define CYCLE_AVX2 0
+#endif
+
+static inline void tCycleSinesLoop(const uint32_t* phase, float* out, size_t n)
+{
+    for (size_t i = 0; i < n; i++) out[i] = tCycleSine(phase[i]);
+}
+
+#if CYCLE_AVX2
+__attribute__((target("avx2"))) static void tCycleSinesAVX2(const uint32_t* phase, float* out, size_t n)
+{
+    tCycleSinesLoop(phase, out, n);
+}
+#endif
+
+// The sines of n phases into out.
+static void tCycleSines(const uint32_t* phase, float* out, size_t n)
+{
+#if CYCLE_AVX2
+    if (__builtin_cpu_supports("avx2"))
+    {
+        tCycleSinesAVX2(phase, out, n);
+        return;
+    }
+#endif
+    
+    tCycleSinesLoop(phase, out, n);
+}
+
+// The sines of n Ticks of a held phasor from phase, a chunk at a time. Returns the phase after them.
+static uint32_t tCycleSinesHeld(uint32_t phase, uint32_t inc, float* out, size_t n)
+{
+    uint32_t phases[CYCLE_CHUNK];
+    
+    for (size_t i = 0; i < n; i += CYCLE_CHUNK)
+    {
+        size_t m = n - i < CYCLE_CHUNK ? n - i : CYCLE_CHUNK;
+        
+        for (size_t j = 0; j < m; j++) phases[j] = phase + (uint32_t)(j + 1) * inc;
+        
+        phase += (uint32_t)m * inc;
+        tCycleSines(phases, out + i, m);
+    }
+    
+    return phase;
+}
+#endif
+
 #if N_CYCLE
 // Cycle
 tCycle*    tCycleInit(void)
 {
+    if (oops.registryIndex[T_CYCLE] >= N_CYCLE) return NULL;
+    
     tCycle* c = &oops.tCycleRegistry[oops.registryIndex[T_CYCLE]++];
     
-    c->inc      =  0.0f;
-    c->phase    =  0.0f;
+    c->inc      =  0;
+    c->phase    =  0;
     c->sampleRateChanged = &tCycleSampleRateChanged;
     
     
@@ -242,30 +336,61 @@ int     tCycleSetFreq(tCycle* const c, float freq)
     if (freq < 0.0f) freq = 0.0f;
     
     c->freq = freq;
-    c->inc = freq * oops.invSampleRate;
+    c->inc = tPhaseInc(freq);
     
     return 0;
 }
 
 float   tCycleTick(tCycle* const c)
 {
+    OOPS_PROFILE_START();
+    
     // Phasor increment
     c->phase += c->inc;
-    if (c->phase >= 1.0f) c->phase -= 1.0f;
     
-    // Wavetable synthesis
-    float temp = SINE_TABLE_SIZE * c->phase;
-    int intPart = (int)temp;
-    float fracPart = temp - (float)intPart;
-    float samp0 = sinewave[intPart];
-    if (++intPart >= SINE_TABLE_SIZE) intPart = 0;
-    float samp1 = sinewave[intPart];
-    return (samp0 + (samp1 - samp0) * fracPart);
+    OOPS_PROFILE_RETURN(T_CYCLE, tCycleSine(c->phase));
+}
+
+// The phases are summed one after another, then their sines computed a vector at a time.
+void    tCycleTickBlock(tCycle* const c, const float* freq, float* out, size_t numSamples)
+{
+    OOPS_PROFILE_START();
+    
+    uint32_t phase = c->phase, inc = c->inc, phases[CYCLE_CHUNK];
+    float f = c->freq;
+    
+    if (freq == NULL)
+    {
+        phase = tCycleSinesHeld(phase, inc, out, numSamples);
+    }
+    else
+    {
+        for (size_t i = 0; i < numSamples; i += CYCLE_CHUNK)
+        {
+            size_t m = numSamples - i < CYCLE_CHUNK ? numSamples - i : CYCLE_CHUNK;
+            
+            for (size_t j = 0; j < m; j++)
+            {
+                f = freq[i + j] < 0.0f ? 0.0f : freq[i + j];
+                inc = tPhaseInc(f);
+                phase += inc;
+                phases[j] = phase;
+            }
+            
+            tCycleSines(phases, out + i, m);
+        }
+    }
+    
+    c->phase = phase;
+    c->inc = inc;
+    c->freq = f;
+    
+    OOPS_PROFILE_BLOCK(T_CYCLE, numSamples);
 }
 
 void     tCycleSampleRateChanged (tCycle* const c)
 {
-    c->inc = c->freq * oops.invSampleRate;
+    c->inc = tPhaseInc(c->freq);
 }
 #endif //N_CYCLE
 
@@ -273,7 +398,7 @@ void     tCycleSampleRateChanged (tCycle* const c)
 /* Phasor */
 void     tPhasorSampleRateChanged (tPhasor* const p)
 {
-    p->inc = p->freq * oops.invSampleRate;
+    p->inc = tPhaseInc(p->freq);
 };
 
 int     tPhasorSetFreq(tPhasor* const p, float freq)
@@ -281,18 +406,44 @@ int     tPhasorSetFreq(tPhasor* const p, float freq)
     if (freq < 0.0f) freq = 0.0f;
     
     p->freq = freq;
-    p->inc = freq * oops.invSampleRate;
+    p->inc = tPhaseInc(freq);
     
     return 0;
 }
 
 float   tPhasorTick(tPhasor* const p)
 {
+    OOPS_PROFILE_START();
+    
     p->phase += p->inc;
     
-    if (p->phase >= 1.0f) p->phase -= 1.0f;
+    OOPS_PROFILE_RETURN(T_PHASOR, tPhaseFloat(p->phase));
+}
+
+void    tPhasorTickBlock(tPhasor* const p, const float* freq, float* out, size_t numSamples)
+{
+    OOPS_PROFILE_START();
+    
+    uint32_t phase = p->phase, inc = p->inc;
+    float f = p->freq;
+    
+    for (size_t i = 0; i < numSamples; i++)
+    {
+        if (freq != NULL)
+        {
+            f = freq[i] < 0.0f ? 0.0f : freq[i];
+            inc = tPhaseInc(f);
+        }
+        
+        phase += inc;
+        out[i] = tPhaseFloat(phase);
+    }
+    
+    p->phase = phase;
+    p->inc = inc;
+    p->freq = f;
     
-    return p->phase;
+    OOPS_PROFILE_BLOCK(T_PHASOR, numSamples);
 }
 
 tPhasor*    tPhasorInit(void)
@@ -301,8 +452,8 @@ tPhasor*    tPhasorInit(void)
     
     tPhasor* p = &oops.tPhasorRegistry[oops.registryIndex[T_PHASOR]++];
     
-    p->phase = 0.0f;
-    p->inc = 0.0f;
+    p->phase = 0;
+    p->inc = 0;
     
     p->sampleRateChanged = &tPhasorSampleRateChanged;
     
@@ -311,109 +462,271 @@ tPhasor*    tPhasorInit(void)
 }
 #endif //N_PHASOR
 
-#if N_SAWTOOTH
-tSawtooth*    tSawtoothInit(void)
+#if N_SAWTOOTH || N_TRIANGLE || N_SQUARE || N_MULTIOSC
+// Wavetable core of tSawtooth, tTriangle, tSquare and tMultiOsc.
+
+// The tables of band t of the mipmapped bands in ptr, the log2 of its size in bits.
+static inline void tWavetableBand(const float* bands, int t, const float** ptr, int* bits)
 {
-    if (oops.registryIndex[T_SAWTOOTH] >= N_SAWTOOTH) return NULL;
+    *ptr = bands + wavetableOffset[t];
+    *bits = wavetableBits[t];
+}
+
+// Pick the two bands mixed at freq and the weight of the lower one. Each band covers an octave
+// from 20Hz, below and above those the lowest and highest band plays alone. The band is read off
+// the exponent of freq, no search.
+static inline void tWavetablePick(float freq, int* lower, int* upper, float* w)
+{
+    static const float top[TableNameNil] =
+    {
+        40.0f, 80.0f, 160.0f, 320.0f, 640.0f, 1280.0f, 2560.0f, 5120.0f, 10240.0f, 20480.0f, 40960.0f
+    };
+    static const float inv[TableNameNil] =
+    {
+        INV_20, INV_40, INV_80, INV_160, INV_320, INV_640, INV_1280, INV_2560, INV_5120, INV_10240, INV_20480
+    };
+    union { float f; uint32_t i; } bits = { freq };
     
-    tSawtooth* c = &oops.tSawtoothRegistry[oops.registryIndex[T_SAWTOOTH]++];
+    if (freq <= 20.0f || freq > 20480.0f)
+    {
+        *lower = *upper = freq <= 20.0f ? T20 : T20480;
+        *w = 1.0f;
+        return;
+    }
     
-    c->inc      = 0.0f;
-    c->phase    = 0.0f;
+    // freq is in [2^e, 2^(e+1)), which holds the top of band e - 5 or e - 4
+    int t = (int)(bits.i >> 23) - 127 - 5;
+    if (t < T20) t = T20;
+    t += freq > top[t];
     
-    c->sampleRateChanged = &tSawtoothSampleRateChanged;
+    *lower = t;
+    *upper = t + 1;
+    *w = (top[t] - freq) * inv[t];
+}
+
+static inline void tWavetableBands(tWavetable* const c, float freq)
+{
+    int lower, upper;
     
-    return c;
+    tWavetablePick(freq, &lower, &upper, &c->w);
+    tWavetableBand(c->bands, lower, &c->lower, &c->lowerBits);
+    tWavetableBand(c->bands, upper, &c->upper, &c->upperBits);
 }
 
-int     tSawtoothSetFreq(tSawtooth* const c, float freq)
+static void tWavetableInit(tWavetable* const c, OscWave wave, const float* table)
+{
+    c->inc      = 0;
+    c->phase    = 0;
+    c->freq     = 0.0f;
+    c->wave     = wave;
+    c->mode     = OscModeWavetable;
+    c->bands    = table;
+    tWavetableBands(c, 0.0f);
+}
+
+static inline void tWavetableSetFreq(tWavetable* const c, float freq)
 {
     if (freq < 0.0f) freq = 0.0f;
     
     c->freq = freq;
-    c->inc = freq * oops.invSampleRate;
-    
-    return 0;
+    c->inc = tPhaseInc(freq);
+    tWavetableBands(c, freq);
 }
 
-float   tSawtoothTick(tSawtooth* const c)
+// Where phase falls in a band of 2^bits samples, the index of the sample before it and in frac the
+// way to the next. Shifted up by bits, the phase has the index in its top word and the fraction in
+// the bottom one.
+static inline uint32_t tWavetableIndex(int bits, uint32_t phase, float* frac)
 {
-    // Phasor increment
-    c->phase += c->inc;
-    if (c->phase >= 1.0f) c->phase -= 1.0f;
-    
-    float out = 0.0f;
-    float w;
-    
-    int idx = (int)(c->phase * TRI_TABLE_SIZE);
+    uint64_t pos = (uint64_t)phase << bits;
+    *frac = tPhaseFloat((uint32_t)pos);
     
-    // Wavetable synthesis
+    return (uint32_t)(pos >> 32);
+}
+
+// Linear interpolation from sample[0] to sample[1]. The copy of the first sample of a band after
+// the last stands in for a wrap.
+static inline float tWavetableLerp(const float* sample, float frac)
+{
+    return sample[0] + (sample[1] - sample[0]) * frac;
+}
+
+// Linearly interpolated read of a band of 2^bits samples at phase.
+static inline float tWavetableRead(const float* table, int bits, uint32_t phase)
+{
+    float frac;
+    uint32_t i = tWavetableIndex(bits, phase, &frac);
     
-    if (c->freq <= 20.0f)
-    {
-        out = sawtooth[T20][idx];
-    }
-    else if (c->freq <= 40.0f)
-    {
-        w = ((40.0f - c->freq) * INV_20);
-        out = (sawtooth[T20][idx] * w) + (sawtooth[T40][idx] * (1.0f - w));
-    }
-    else if (c->freq <= 80.0f)
-    {
-        w = ((80.0f - c->freq) * INV_40);
-        out = (sawtooth[T40][idx] * w) + (sawtooth[T80][idx] * (1.0f - w));
-    }
-    else if (c->freq <= 160.0f)
+    return tWavetableLerp(table + i, frac);
+}
+
+// The residual of a band limited step of 2 at phase 0, spread over the sample either side of it.
+// t is the phase since the step and dt the phase increment. The divisions are only made next to
+// the step.
+static inline float tPolyBLEP(float t, float dt)
+{
+    if (t < dt)
     {
-        w = ((160.0f - c->freq) * INV_80);
-        out = (sawtooth[T80][idx] * w) + (sawtooth[T160][idx] * (1.0f - w));
+        t = t / dt;
+        return t + t - t * t - 1.0f;
     }
-    else if (c->freq <= 320.0f)
+    else if (t > 1.0f - dt)
     {
-        w = ((320.0f - c->freq) * INV_160);
-        out = (sawtooth[T160][idx] * w) + (sawtooth[T320][idx] * (1.0f - w));
+        t = (t - 1.0f) / dt;
+        return t * t + t + t + 1.0f;
     }
-    else if (c->freq <= 640.0f)
+    
+    return 0.0f;
+}
+
+// The residual of a band limited corner at phase 0 where the slope rises by 1 a sample, the
+// integral of the step residual.
+static inline float tPolyBLAMP(float t, float dt)
+{
+    if (t < dt)
     {
-        w = ((640.0f - c->freq) * INV_320);
-        out = (sawtooth[T320][idx] * w) + (sawtooth[T640][idx] * (1.0f - w));
+        t = 1.0f - t / dt;
+        return t * t * t * (1.0f / 6.0f);
     }
-    else if (c->freq <= 1280.0f)
+    else if (t > 1.0f - dt)
     {
-        w = ((1280.0f - c->freq) * INV_640);
-        out = (sawtooth[T640][idx] * w) + (sawtooth[T1280][idx] * (1.0f - w));
+        t = 1.0f + (t - 1.0f) / dt;
+        return t * t * t * (1.0f / 6.0f);
     }
-    else if (c->freq <= 2560.0f)
+    
+    return 0.0f;
+}
+
+// The wave at phase for an increment of dt, drawn naively and corrected around its steps and
+// corners. Scaled to the level of the tables.
+static inline float tWavetablePolyBLEP(OscWave wave, uint32_t turn, float dt)
+{
+    float out, phase = tPhaseFloat(turn), half = tPhaseFloat(turn + 0x80000000u);
+    
+    if (wave == OscWaveSawtooth)
     {
-        w = ((2560.0f - c->freq) * INV_1280);
-        out = (sawtooth[T1280][idx] * w) + (sawtooth[T2560][idx] * (1.0f - w));
+        // Rising, falls by 2 at phase 0
+        out = 2.0f * phase - 1.0f - tPolyBLEP(phase, dt);
+        return out * (PI * 0.25f);
     }
-    else if (c->freq <= 5120.0f)
+    else if (wave == OscWaveSquare)
     {
-        w = ((5120.0f - c->freq) * INV_2560);
-        out = (sawtooth[T2560][idx] * w) + (sawtooth[T5120][idx] * (1.0f - w));
+        // Low for the first half, falls at phase 0 and rises at 0.5
+        out = (phase < 0.5f ? -1.0f : 1.0f) - tPolyBLEP(phase, dt) + tPolyBLEP(half, dt);
+        return out * (PI * 0.25f);
     }
-    else if (c->freq <= 10240.0f)
+    
+    // Triangle, peaks at phase 0.75 and dips at 0.25 where its slope of 4 turns
+    float quarter = tPhaseFloat(turn + 0x40000000u);
+    float dip = tPhaseFloat(turn + 0xC0000000u);
+    
+    out = 2.0f * fabsf(2.0f * quarter - 1.0f) - 1.0f;
+    out += 8.0f * dt * (tPolyBLAMP(dip, dt) - tPolyBLAMP(quarter, dt));
+    return out * (PI * PI * 0.75f * 0.125f);
+}
+
+static inline float tWavetableTick(tWavetable* const c)
+{
+    // Phasor increment
+    c->phase += c->inc;
+    
+    if (c->mode == OscModePolyBLEP) return tWavetablePolyBLEP(c->wave, c->phase, (float)c->inc * INV_TWO_TO_32);
+    
+    return (tWavetableRead(c->lower, c->lowerBits, c->phase) * c->w) +
+           (tWavetableRead(c->upper, c->upperBits, c->phase) * (1.0f - c->w));
+}
+
+// The Tick over a block on a copy of c, so the phasor and bands stay in registers. Only a freq
+// buffer moves the bands within the block, so a held frequency reads the same two throughout.
+static inline void tWavetableTickBlock(tWavetable* const c, const float* freq, float* out, size_t numSamples)
+{
+    tWavetable v = *c;
+    
+    if (v.mode == OscModePolyBLEP)
     {
-        w = ((10240.0f - c->freq) * INV_5120);
-        out = (sawtooth[T5120][idx] * w) + (sawtooth[T10240][idx] * (1.0f - w));
+        for (size_t i = 0; i < numSamples; i++)
+        {
+            if (freq != NULL) tWavetableSetFreq(&v, freq[i]);
+            
+            out[i] = tWavetableTick(&v);
+        }
     }
-    else if (c->freq <= 20480.0f)
+    else if (freq == NULL)
     {
-        w = ((20480.0f - c->freq) * INV_10240);
-        out = (sawtooth[T10240][idx] * w) + (sawtooth[T20480][idx] * (1.0f - w));
+        for (size_t i = 0; i < numSamples; i++)
+        {
+            v.phase += v.inc;
+            out[i] = (tWavetableRead(v.lower, v.lowerBits, v.phase) * v.w) +
+                     (tWavetableRead(v.upper, v.upperBits, v.phase) * (1.0f - v.w));
+        }
     }
     else
     {
-        out = sawtooth[T20480][idx];
+        for (size_t i = 0; i < numSamples; i++)
+        {
+            tWavetableSetFreq(&v, freq[i]);
+            v.phase += v.inc;
+            out[i] = (tWavetableRead(v.lower, v.lowerBits, v.phase) * v.w) +
+                     (tWavetableRead(v.upper, v.upperBits, v.phase) * (1.0f - v.w));
+        }
     }
     
-    return out;
+    *c = v;
+}
+
+static void tWavetableSampleRateChanged(tWavetable* const c)
+{
+    c->inc = tPhaseInc(c->freq);
+}
+#endif
+
+#if N_SAWTOOTH
+tSawtooth*    tSawtoothInit(void)
+{
+    if (oops.registryIndex[T_SAWTOOTH] >= N_SAWTOOTH) return NULL;
+    
+    tSawtooth* c = &oops.tSawtoothRegistry[oops.registryIndex[T_SAWTOOTH]++];
+    
+    tWavetableInit(c, OscWaveSawtooth, sawtooth);
+    
+    c->sampleRateChanged = &tSawtoothSampleRateChanged;
+    
+    return c;
+}
+
+int     tSawtoothSetFreq(tSawtooth* const c, float freq)
+{
+    tWavetableSetFreq(c, freq);
+    
+    return 0;
+}
+
+void    tSawtoothSetMode(tSawtooth* const c, OscMode mode)
+{
+    c->mode = mode;
+}
+
+float   tSawtoothTick(tSawtooth* const c)
+{
+    OOPS_PROFILE_START();
+    
+    float out = tWavetableTick(c);
+    
+    OOPS_PROFILE_RETURN(T_SAWTOOTH, out);
+}
+
+void    tSawtoothTickBlock(tSawtooth* const c, const float* freq, float* out, size_t numSamples)
+{
+    OOPS_PROFILE_START();
+    
+    tWavetableTickBlock(c, freq, out, numSamples);
+    
+    OOPS_PROFILE_BLOCK(T_SAWTOOTH, numSamples);
 }
 
 void     tSawtoothSampleRateChanged (tSawtooth* const c)
 {
-    c->inc = c->freq * oops.invSampleRate;
+    tWavetableSampleRateChanged(c);
 }
 #endif //N_SAWTOOTH
 
@@ -430,103 +743,46 @@ tTriangle*    tTriangleInit(void)
     
     tTriangle* c = &oops.tTriangleRegistry[oops.registryIndex[T_TRIANGLE]++];
     
-    c->inc      =  0.0f;
-    c->phase    =  0.0f;
+    tWavetableInit(c, OscWaveTriangle, triangle);
     
     c->sampleRateChanged = &tTriangleSampleRateChanged;
     
     return c;
 }
 
-int tTriangleSetFreq(tTriangle* const c, float freq)
+int     tTriangleSetFreq(tTriangle* const c, float freq)
 {
-    if (freq < 0.0f) freq = 0.0f;
-    
-    c->freq = freq;
-    c->inc = freq * oops.invSampleRate;
+    tWavetableSetFreq(c, freq);
     
     return 0;
 }
 
+void    tTriangleSetMode(tTriangle* const c, OscMode mode)
+{
+    c->mode = mode;
+}
 
 float   tTriangleTick(tTriangle* const c)
 {
-    // Phasor increment
-    c->phase += c->inc;
-    if (c->phase >= 1.0f) c->phase -= 1.0f;
+    OOPS_PROFILE_START();
     
-    float out = 0.0f;
-    float w;
+    float out = tWavetableTick(c);
     
-    int idx = (int)(c->phase * TRI_TABLE_SIZE);
+    OOPS_PROFILE_RETURN(T_TRIANGLE, out);
+}
+
+void    tTriangleTickBlock(tTriangle* const c, const float* freq, float* out, size_t numSamples)
+{
+    OOPS_PROFILE_START();
     
-    // Wavetable synthesis
+    tWavetableTickBlock(c, freq, out, numSamples);
     
-    if (c->freq <= 20.0f)
-    {
-        out = triangle[T20][idx];
-    }
-    else if (c->freq <= 40.0f)
-    {
-        w = ((40.0f - c->freq) * INV_20);
-        out = (triangle[T20][idx] * w) + (triangle[T40][idx] * (1.0f - w));
-    }
-    else if (c->freq <= 80.0f)
-    {
-        w = ((80.0f - c->freq) * INV_40);
-        out = (triangle[T40][idx] * w) + (triangle[T80][idx] * (1.0f - w));
-    }
-    else if (c->freq <= 160.0f)
-    {
-        w = ((160.0f - c->freq) * INV_80);
-        out = (triangle[T80][idx] * w) + (triangle[T160][idx] * (1.0f - w));
-    }
-    else if (c->freq <= 320.0f)
-    {
-        w = ((320.0f - c->freq) * INV_160);
-        out = (triangle[T160][idx] * w) + (triangle[T320][idx] * (1.0f - w));
-    }
-    else if (c->freq <= 640.0f)
-    {
-        w = ((640.0f - c->freq) * INV_320);
-        out = (triangle[T320][idx] * w) + (triangle[T640][idx] * (1.0f - w));
-    }
-    else if (c->freq <= 1280.0f)
-    {
-        w = ((1280.0f - c->freq) * INV_640);
-        out = (triangle[T640][idx] * w) + (triangle[T1280][idx] * (1.0f - w));
-    }
-    else if (c->freq <= 2560.0f)
-    {
-        w = ((2560.0f - c->freq) * INV_1280);
-        out = (triangle[T1280][idx] * w) + (triangle[T2560][idx] * (1.0f - w));
-    }
-    else if (c->freq <= 5120.0f)
-    {
-        w = ((5120.0f - c->freq) * INV_2560);
-        out = (triangle[T2560][idx] * w) + (triangle[T5120][idx] * (1.0f - w));
-    }
-    else if (c->freq <= 10240.0f)
-    {
-        w = ((10240.0f - c->freq) * INV_5120);
-        out = (triangle[T5120][idx] * w) + (triangle[T10240][idx] * (1.0f - w));
-    }
-    else if (c->freq <= 20480.0f)
-    {
-        w = ((20480.0f - c->freq) * INV_10240);
-        out = (triangle[T10240][idx] * w) + (triangle[T20480][idx] * (1.0f - w));
-    }
-    else
-    {
-        out = triangle[T20480][idx];
-    }
-    
-    return out;
+    OOPS_PROFILE_BLOCK(T_TRIANGLE, numSamples);
 }
 
-void     tTriangleSampleRateChanged (tTriangle*  const c)
+void     tTriangleSampleRateChanged (tTriangle* const c)
 {
-    c->inc = c->freq * oops.invSampleRate;
+    tWavetableSampleRateChanged(c);
 }
 #endif //N_TRIANGLE
 
@@ -538,102 +794,196 @@ tSquare*    tSquareInit(void)
     
     tSquare* c = &oops.tSquareRegistry[oops.registryIndex[T_SQUARE]++];
     
-    c->inc      =  0.0f;
-    c->phase    =  0.0f;
+    tWavetableInit(c, OscWaveSquare, squarewave);
+    
     c->sampleRateChanged = &tSquareSampleRateChanged;
     
     return c;
 }
 
-int     tSquareSetFreq(tSquare*  const c, float freq)
+int     tSquareSetFreq(tSquare* const c, float freq)
+{
+    tWavetableSetFreq(c, freq);
+    
+    return 0;
+}
+
+void    tSquareSetMode(tSquare* const c, OscMode mode)
+{
+    c->mode = mode;
+}
+
+float   tSquareTick(tSquare* const c)
+{
+    OOPS_PROFILE_START();
+    
+    float out = tWavetableTick(c);
+    
+    OOPS_PROFILE_RETURN(T_SQUARE, out);
+}
+
+void    tSquareTickBlock(tSquare* const c, const float* freq, float* out, size_t numSamples)
+{
+    OOPS_PROFILE_START();
+    
+    tWavetableTickBlock(c, freq, out, numSamples);
+    
+    OOPS_PROFILE_BLOCK(T_SQUARE, numSamples);
+}
+
+void     tSquareSampleRateChanged (tSquare* const c)
 {
+    tWavetableSampleRateChanged(c);
+}
+#endif //N_SQUARE
+
+#if N_MULTIOSC
+/* MultiOsc */
+static inline void tMultiOscFreq(tMultiOsc* const c, float freq)
+{
+    int lower, upper;
+    
     if (freq < 0.0f) freq = 0.0f;
     
     c->freq = freq;
-    c->inc = freq * oops.invSampleRate;
+    c->inc = tPhaseInc(freq);
+    
+    tWavetablePick(freq, &lower, &upper, &c->w);
+    c->lower = wavetableOffset[lower];
+    c->upper = wavetableOffset[upper];
+    c->lowerBits = wavetableBits[lower];
+    c->upperBits = wavetableBits[upper];
+}
+
+tMultiOsc*    tMultiOscInit(void)
+{
+    if (oops.registryIndex[T_MULTIOSC] >= N_MULTIOSC) return NULL;
+    
+    tMultiOsc* c = &oops.tMultiOscRegistry[oops.registryIndex[T_MULTIOSC]++];
+    
+    c->inc      = 0;
+    c->phase    = 0;
+    c->mode     = OscModeWavetable;
+    tMultiOscFreq(c, 0.0f);
+    
+    c->sampleRateChanged = &tMultiOscSampleRateChanged;
+    
+    return c;
+}
+
+int     tMultiOscSetFreq(tMultiOsc* const c, float freq)
+{
+    tMultiOscFreq(c, freq);
     
     return 0;
 }
 
-float   tSquareTick(tSquare* const c)
+void    tMultiOscSetMode(tMultiOsc* const c, OscMode mode)
 {
+    c->mode = mode;
+}
+
+// Sample i of the waves at the phase of c, into those of saw, sqr, tri and sine that are not NULL.
+// The three tables are read at the same index and fraction of each band.
+static inline void tMultiOscTables(const tMultiOsc* const c, float* saw, float* sqr, float* tri, float* sine, size_t i)
+{
+    float lowerFrac, upperFrac, w = c->w;
+    uint32_t lower = c->lower + tWavetableIndex(c->lowerBits, c->phase, &lowerFrac);
+    uint32_t upper = c->upper + tWavetableIndex(c->upperBits, c->phase, &upperFrac);
+    
+    if (saw != NULL) saw[i] = (tWavetableLerp(sawtooth + lower, lowerFrac) * w) +
+                              (tWavetableLerp(sawtooth + upper, upperFrac) * (1.0f - w));
+    if (sqr != NULL) sqr[i] = (tWavetableLerp(squarewave + lower, lowerFrac) * w) +
+                              (tWavetableLerp(squarewave + upper, upperFrac) * (1.0f - w));
+    if (tri != NULL) tri[i] = (tWavetableLerp(triangle + lower, lowerFrac) * w) +
+                              (tWavetableLerp(triangle + upper, upperFrac) * (1.0f - w));
+    if (sine != NULL) sine[i] = tCycleSine(c->phase);
+}
+
+// As tMultiOscTables, with the waves drawn by PolyBLEP.
+static inline void tMultiOscPolyBLEP(const tMultiOsc* const c, float* saw, float* sqr, float* tri, float* sine, size_t i)
+{
+    float dt = (float)c->inc * INV_TWO_TO_32;
+    
+    if (saw != NULL) saw[i] = tWavetablePolyBLEP(OscWaveSawtooth, c->phase, dt);
+    if (sqr != NULL) sqr[i] = tWavetablePolyBLEP(OscWaveSquare, c->phase, dt);
+    if (tri != NULL) tri[i] = tWavetablePolyBLEP(OscWaveTriangle, c->phase, dt);
+    if (sine != NULL) sine[i] = tCycleSine(c->phase);
+}
+
+void    tMultiOscTick(tMultiOsc* const c, float* saw, float* sqr, float* tri, float* sine)
+{
+    OOPS_PROFILE_START();
+    
     // Phasor increment
     c->phase += c->inc;
-    if (c->phase >= 1.0f) c->phase -= 1.0f;
     
-    float out = 0.0f;
-    float w = 0.0f;
-    int idx = (int)(c->phase * TRI_TABLE_SIZE);
+    if (c->mode == OscModePolyBLEP) tMultiOscPolyBLEP(c, saw, sqr, tri, sine, 0);
+    else                            tMultiOscTables(c, saw, sqr, tri, sine, 0);
     
-    // Wavetable synthesis
+    OOPS_PROFILE_BLOCK(T_MULTIOSC, 1);
+}
+
+// On a copy of c, as tWavetableTickBlock, with a loop for each mode.
+void    tMultiOscTickBlock(tMultiOsc* const c, const float* freq, float* saw, float* sqr, float* tri, float* sine, size_t numSamples)
+{
+    OOPS_PROFILE_START();
     
-    if (c->freq <= 20.0f)
-    {
-        out = squarewave[T20][idx];
-    }
-    else if (c->freq <= 40.0f)
-    {
-        w = ((40.0f - c->freq) * INV_20);
-        out = (squarewave[T20][idx] * w) + (squarewave[T40][idx] * (1.0f - w));
-    }
-    else if (c->freq <= 80.0f)
-    {
-        w = ((80.0f - c->freq) * INV_40);
-        out = (squarewave[T40][idx] * w) + (squarewave[T80][idx] * (1.0f - w));
-    }
-    else if (c->freq <= 160.0f)
-    {
-        w = ((160.0f - c->freq) * INV_80);
-        out = (squarewave[T80][idx] * w) + (squarewave[T160][idx] * (1.0f - w));
-    }
-    else if (c->freq <= 320.0f)
-    {
-        w = ((320.0f - c->freq) * INV_160);
-        out = (squarewave[T160][idx] * w) + (squarewave[T320][idx] * (1.0f - w));
-    }
-    else if (c->freq <= 640.0f)
-    {
-        w = ((640.0f - c->freq) * INV_320);
-        out = (squarewave[T320][idx] * w) + (squarewave[T640][idx] * (1.0f - w));
-    }
-    else if (c->freq <= 1280.0f)
-    {
-        w = ((1280.0f - c->freq) * INV_640);
-        out = (squarewave[T640][idx] * w) + (squarewave[T1280][idx] * (1.0f - w));
-    }
-    else if (c->freq <= 2560.0f)
-    {
-        w = ((2560.0f - c->freq) * INV_1280);
-        out = (squarewave[T1280][idx] * w) + (squarewave[T2560][idx] * (1.0f - w));
-    }
-    else if (c->freq <= 5120.0f)
-    {
-        w = ((5120.0f - c->freq) * INV_2560);
-        out = (squarewave[T2560][idx] * w) + (squarewave[T5120][idx] * (1.0f - w));
-    }
-    else if (c->freq <= 10240.0f)
-    {
-        w = ((10240.0f - c->freq) * INV_5120);
-        out = (squarewave[T5120][idx] * w) + (squarewave[T10240][idx] * (1.0f - w));
-    }
-    else if (c->freq <= 20480.0f)
-    {
-        w = ((20480.0f - c->freq) * INV_10240);
-        out = (squarewave[T10240][idx] * w) + (squarewave[T20480][idx] * (1.0f - w));
-    }
-    else
+    tMultiOsc v = *c;
+    uint32_t phases[CYCLE_CHUNK];
+    int waves = saw != NULL || sqr != NULL || tri != NULL;
+    
+    // A chunk at a time, the sines of its phases are computed after the other waves a vector at a time
+    for (size_t i = 0; i < numSamples; i += CYCLE_CHUNK)
     {
-        out = squarewave[T20480][idx];
+        size_t m = numSamples - i < CYCLE_CHUNK ? numSamples - i : CYCLE_CHUNK;
+        
+        if (!waves)
+        {
+            for (size_t j = 0; j < m; j++)
+            {
+                if (freq != NULL) tMultiOscFreq(&v, freq[i + j]);
+                
+                v.phase += v.inc;
+                phases[j] = v.phase;
+            }
+        }
+        else if (v.mode == OscModePolyBLEP)
+        {
+            for (size_t j = 0; j < m; j++)
+            {
+                if (freq != NULL) tMultiOscFreq(&v, freq[i + j]);
+                
+                v.phase += v.inc;
+                phases[j] = v.phase;
+                tMultiOscPolyBLEP(&v, saw, sqr, tri, NULL, i + j);
+            }
+        }
+        else
+        {
+            for (size_t j = 0; j < m; j++)
+            {
+                if (freq != NULL) tMultiOscFreq(&v, freq[i + j]);
+                
+                v.phase += v.inc;
+                phases[j] = v.phase;
+                tMultiOscTables(&v, saw, sqr, tri, NULL, i + j);
+            }
+        }
+        
+        if (sine != NULL) tCycleSines(phases, sine + i, m);
     }
     
-    return out;
+    *c = v;
+    
+    OOPS_PROFILE_BLOCK(T_MULTIOSC, numSamples);
 }
 
-void     tSquareSampleRateChanged (tSquare*  const c)
+void     tMultiOscSampleRateChanged (tMultiOsc* const c)
 {
-    c->inc = c->freq * oops.invSampleRate;
+    c->inc = tPhaseInc(c->freq);
 }
-#endif //N_SQUARE
+#endif //N_MULTIOSC
 
 #if N_NOISE
 /* Noise */
@@ -652,6 +1002,8 @@ tNoise*    tNoiseInit(NoiseType type)
 
 float   tNoiseTick(tNoise* const n)
 {
+    OOPS_PROFILE_START();
+    
     float rand = n->rand();
     
     if (n->type == PinkNoise)
@@ -661,11 +1013,40 @@ float   tNoiseTick(tNoise* const n)
         n->pinkb1 = 0.96300f * n->pinkb1 + rand * 0.2965164f;
         n->pinkb2 = 0.57000f * n->pinkb2 + rand * 1.0526913f;
         tmp = n->pinkb0 + n->pinkb1 + n->pinkb2 + rand * 0.1848f;
-        return (tmp * 0.05f);
+        OOPS_PROFILE_RETURN(T_NOISE, (tmp * 0.05f));
+    }
+    else // WhiteNoise
+    {
+        OOPS_PROFILE_RETURN(T_NOISE, rand);
+    }
+}
+
+void    tNoiseTickBlock(tNoise* const n, float* out, size_t numSamples)
+{
+    OOPS_PROFILE_START();
+    
+    if (n->type == PinkNoise)
+    {
+        float b0 = n->pinkb0, b1 = n->pinkb1, b2 = n->pinkb2;
+        
+        for (size_t i = 0; i < numSamples; i++)
+        {
+            float rand = n->rand();
+            b0 = 0.99765f * b0 + rand * 0.0990460f;
+            b1 = 0.96300f * b1 + rand * 0.2965164f;
+            b2 = 0.57000f * b2 + rand * 1.0526913f;
+            out[i] = (b0 + b1 + b2 + rand * 0.1848f) * 0.05f;
+        }
+        
+        n->pinkb0 = b0;
+        n->pinkb1 = b1;
+        n->pinkb2 = b2;
     }
     else // WhiteNoise
     {
-        return rand;
+        for (size_t i = 0; i < numSamples; i++)   out[i] = n->rand();
     }
+    
+    OOPS_PROFILE_BLOCK(T_NOISE, numSamples);
 }
 #endif //N_NOISE
@@ -82,6 +82,8 @@ void    tPRCRevSetMix(tPRCRev* const r, float mix)
 
 float   tPRCRevTick(tPRCRev* const r, float input)
 {
+    OOPS_PROFILE_START();
+    
     float temp, temp0, temp1, temp2;
     float out;
     
@@ -109,7 +111,13 @@ float   tPRCRevTick(tPRCRev* const r, float input)
     
     r->lastOut = out;
     
-    return out;
+    OOPS_PROFILE_RETURN(T_PRCREV, out);
+}
+
+void    tPRCRevTickBlock(tPRCRev* const r, const float* in, float* out, size_t numSamples)
+{
+    // The delays feed back within the block, so this is the Tick in a loop.
+    for (size_t i = 0; i < numSamples; i++)   out[i] = tPRCRevTick(r, in[i]);
 }
 
 void     tPRCRevSampleRateChanged (tPRCRev* const r)
@@ -187,6 +195,8 @@ void    tNRevSetMix(tNRev* const r, float mix)
 
 float   tNRevTick(tNRev* const r, float input)
 {
+    OOPS_PROFILE_START();
+    
     r->lastIn = input;
     
     float temp, temp0, temp1, temp2, out;
@@ -236,7 +246,13 @@ float   tNRevTick(tNRev* const r, float input)
     
     r->lastOut = out;
     
-    return out;
+    OOPS_PROFILE_RETURN(T_NREV, out);
+}
+
+void    tNRevTickBlock(tNRev* const r, const float* in, float* out, size_t numSamples)
+{
+    // The delays feed back within the block, so this is the Tick in a loop.
+    for (size_t i = 0; i < numSamples; i++)   out[i] = tNRevTick(r, in[i]);
 }
 
 
@@ -68,6 +68,8 @@ tCompressor*    tCompressorInit(void)
 int ccount = 0;
 float tCompressorTick(tCompressor* c, float in)
 {
+    OOPS_PROFILE_START();
+    
     float slope, overshoot;
     float alphaAtt, alphaRel;
     
@@ -120,11 +122,17 @@ float tCompressorTick(tCompressor* c, float in)
         DBG("attenuation: " + String(attenuation));
     }
     */
-    return attenuation * in;
+    OOPS_PROFILE_RETURN(T_COMPRESSOR, attenuation * in);
     
 
 }
 
+void tCompressorTickBlock(tCompressor* c, const float* in, float* out, size_t numSamples)
+{
+    // The gain computer is all transcendentals, so this is the Tick in a loop.
+    for (size_t i = 0; i < numSamples; i++)   out[i] = tCompressorTick(c, in[i]);
+}
+
 
 #endif
 #if N_ENVELOPE
@@ -238,6 +246,8 @@ int     tEnvelopeOn(tEnvelope* const env, float velocity)
 
 float   tEnvelopeTick(tEnvelope* const env)
 {
+    OOPS_PROFILE_START();
+    
     if (env->inRamp)
     {
         if (env->rampPhase > UINT16_MAX)
@@ -303,7 +313,13 @@ float   tEnvelopeTick(tEnvelope* const env)
         env->decayPhase += env->decayInc;
     }
     
-    return env->next;
+    OOPS_PROFILE_RETURN(T_ENVELOPE, env->next);
+}
+
+void    tEnvelopeTickBlock(tEnvelope* const env, float* out, size_t numSamples)
+{
+    // Mostly branches on the stage, so this is the Tick in a loop.
+    for (size_t i = 0; i < numSamples; i++)   out[i] = tEnvelopeTick(env);
 }
 
 #endif // N_ENVELOPE
@@ -324,6 +340,8 @@ tEnvelopeFollower*    tEnvelopeFollowerInit(float attackThreshold, float decayCo
 
 float   tEnvelopeFollowerTick(tEnvelopeFollower* const ef, float x)
 {
+    OOPS_PROFILE_START();
+    
     if (x < 0.0f ) x = -x;  /* Absolute value. */
     
     if ((x >= ef->y) && (x > ef->a_thresh)) ef->y = x;                      /* If we hit a peak, ride the peak to the top. */
@@ -334,7 +352,32 @@ float   tEnvelopeFollowerTick(tEnvelopeFollower* const ef, float x)
     
     if( ef->y < VSF)   ef->y = 0.0f;
     
-    return ef->y;
+    OOPS_PROFILE_RETURN(T_ENVELOPEFOLLOW, ef->y);
+}
+
+void    tEnvelopeFollowerTickBlock(tEnvelopeFollower* const ef, const float* in, float* out, size_t numSamples)
+{
+    OOPS_PROFILE_START();
+    
+    float y = ef->y, a_thresh = ef->a_thresh, d_coeff = ef->d_coeff;
+    
+    for (size_t i = 0; i < numSamples; i++)
+    {
+        float x = in[i];
+        
+        if (x < 0.0f ) x = -x;
+        
+        if ((x >= y) && (x > a_thresh)) y = x;
+        else                            y = y * d_coeff;
+        
+        if( y < VSF)   y = 0.0f;
+        
+        out[i] = y;
+    }
+    
+    ef->y = y;
+    
+    OOPS_PROFILE_BLOCK(T_ENVELOPEFOLLOW, numSamples);
 }
 
 int     tEnvelopeFollowerDecayCoeff(tEnvelopeFollower* const ef, float decayCoeff)
@@ -400,12 +443,34 @@ int     tRampSetDest(tRamp* const r, float dest)
 }
 
 float   tRampTick(tRamp* const r) {
+    OOPS_PROFILE_START();
     
     r->curr += r->inc;
     
     if (((r->curr >= r->dest) && (r->inc > 0.0f)) || ((r->curr <= r->dest) && (r->inc < 0.0f))) r->inc = 0.0f;
     
-    return r->curr;
+    OOPS_PROFILE_RETURN(T_RAMP, r->curr);
+}
+
+void    tRampTickBlock(tRamp* const r, float* out, size_t numSamples)
+{
+    OOPS_PROFILE_START();
+    
+    float curr = r->curr, inc = r->inc, dest = r->dest;
+    
+    for (size_t i = 0; i < numSamples; i++)
+    {
+        curr += inc;
+        
+        if (((curr >= dest) && (inc > 0.0f)) || ((curr <= dest) && (inc < 0.0f))) inc = 0.0f;
+        
+        out[i] = curr;
+    }
+    
+    r->curr = curr;
+    r->inc = inc;
+    
+    OOPS_PROFILE_BLOCK(T_RAMP, numSamples);
 }
 
 float   tRampSample(tRamp* const r) {
@@ -461,6 +526,8 @@ static void onListInit(tPolyphonicHandler* poly)
 
 tPolyphonicHandler*    tPolyphonicHandlerInit()
 {
+    if (oops.registryIndex[T_POLYPHONICHANDLER] >= N_POLYPHONICHANDLER) return NULL;
+    
     tPolyphonicHandler* poly = &oops.tPolyphonicHandlerRegistry[oops.registryIndex[T_POLYPHONICHANDLER]++];
     nodeListInit(poly);
     offListInit(poly);
@@ -1,7 +1,9 @@
 #include <errno.h>
 #include <getopt.h>
 #include <math.h>
+#include <stdatomic.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -12,12 +14,15 @@
 #include "OOPS/Inc/OOPS.h"
 
 #include "clis.h"
+#include "clis_control.h"
+#include "clis_render.h"
+#include "clis_stats.h"
 
 typedef struct process_data {
-    tSawtooth       *saw;
-    tSquare         *sqr;
-    tTriangle       *tri;
-    tCycle          *sin;
+    tMultiOsc       *osc;
+    // the outputs of the current period and which of them are connected
+    unsigned int    connected;
+    jack_default_audio_sample_t *saw_out, *sqr_out, *tri_out, *sin_out;
 } process_data;
 
 jack_port_t     *saw_output_port;
@@ -25,20 +30,30 @@ jack_port_t     *sqr_output_port;
 jack_port_t     *tri_output_port;
 jack_port_t     *sin_output_port;
 
-parameter        freq = {
-    .value = 200, 
-    .mods = {0, NULL}
+// TODO dynamic sample rate
+// the parameters, in the order of the enum below
+static const clis_param_def param_defs[] = {
+    { "freq", 'f', 200, 0, 20000, 44100, 0, CLIS_SMOOTH_NONE },
+    { "amp",  'a', 1,   0, 1,     1,     0, CLIS_SMOOTH_NONE }
 };
+enum { PARAM_FREQ, PARAM_AMP, PARAMS_LENGTH };
+
+parameter        params[PARAMS_LENGTH];
+// parameter names in the control stream, in the order of context.params
+const char      *param_names[PARAMS_LENGTH];
 clis_context context = {
-    .params_length = 1,
-    .params = &freq,
+    .params_length = PARAMS_LENGTH,
+    .params = params,
+    .names = param_names,
     .client = NULL
 };
+clis_control     control;
 
 // helper to allow us to call clis_close with no arguments with 'atexit'
 static void
 cleanup() {
     clis_close(&context);
+    clis_control_stop(&control);
 }
 
 static float
@@ -47,52 +62,125 @@ frandom(void)
     return (float)rand() / (float)(RAND_MAX);
 }
 
-static int
-process(jack_nframes_t nframes, void *arg)
+// bits of the outputs that are connected to something
+#define OUT_SAW     (1u << 0)
+#define OUT_SQR     (1u << 1)
+#define OUT_TRI     (1u << 2)
+#define OUT_SIN     (1u << 3)
+
+atomic_uint      connected_outputs;
+
+/**
+ * JACK port connect callback, recomputes which outputs have consumers so the
+ * process thread only renders those.
+ */
+static void
+port_connected(jack_port_id_t a, jack_port_id_t b, int connect, void *arg)
 {
-    unsigned int i;
-    jack_default_audio_sample_t *saw_out, *sqr_out, *tri_out, *sin_out, *mod;
-    process_data *data = (process_data*)arg;
-    float f = freq.value;
+    unsigned int mask = 0;
 
-    saw_out = (jack_default_audio_sample_t*)jack_port_get_buffer(saw_output_port, nframes);
-    sqr_out = (jack_default_audio_sample_t*)jack_port_get_buffer(sqr_output_port, nframes);
-    tri_out = (jack_default_audio_sample_t*)jack_port_get_buffer(tri_output_port, nframes);
-    sin_out = (jack_default_audio_sample_t*)jack_port_get_buffer(sin_output_port, nframes);
+    (void)a;
+    (void)b;
+    (void)connect;
+    (void)arg;
 
-    mod = clis_get_mod_buffer(nframes, &freq.mods);
+    if(jack_port_connected(saw_output_port)) mask |= OUT_SAW;
+    if(jack_port_connected(sqr_output_port)) mask |= OUT_SQR;
+    if(jack_port_connected(tri_output_port)) mask |= OUT_TRI;
+    if(jack_port_connected(sin_output_port)) mask |= OUT_SIN;
 
-    if(mod) {
-        for(i = 0; i < nframes; i++) {
-            f = freq.value + mod[i];
+    atomic_store(&connected_outputs, mask);
+}
 
-            tSawtoothSetFreq(data->saw, f);
-            tSquareSetFreq(data->sqr, f);
-            tTriangleSetFreq(data->tri, f);
-            tCycleSetFreq(data->sin, f);
+// scales the frames first to first + n of out by amp
+static void
+scale(jack_default_audio_sample_t *out, const jack_default_audio_sample_t *amp,
+        jack_nframes_t first, jack_nframes_t n)
+{
+    jack_nframes_t j;
+
+    for(j = first; j < first + n; j++) {
+        out[j] *= amp[j];
+    }
+}
+
+// out + i, or NULL for an output that is not rendered
+static jack_default_audio_sample_t *
+frames(jack_default_audio_sample_t *out, jack_nframes_t i)
+{
+    return out != NULL ? out + i : NULL;
+}
 
-            saw_out[i] = tSawtoothTick(data->saw);
-            sqr_out[i] = tSquareTick(data->sqr);
-            tri_out[i] = tTriangleTick(data->tri);
-            sin_out[i] = tCycleTick(data->sin);
+// renders the frames offset to offset + nframes of every connected output,
+// a block at a time while the frequency holds
+static void
+render(void *arg, jack_nframes_t offset, jack_nframes_t nframes)
+{
+    jack_nframes_t i, j, n;
+    jack_default_audio_sample_t *values[PARAMS_LENGTH], *freq, *amp;
+    jack_default_audio_sample_t *saw, *sqr, *tri, *sine;
+    process_data *data = (process_data*)arg;
+    clis_segment segment;
+    float inc_scale = TWO_TO_32 / OOPSGetSampleRate();
+    int32_t inc;
+
+    clis_eval_params(params, PARAMS_LENGTH, offset, nframes, values);
+    freq    = values[PARAM_FREQ];
+    amp     = values[PARAM_AMP];
+
+    if(data->connected == 0)
+        return;
+
+    // the waves share one phasor, those not connected are not read
+    saw = data->connected & OUT_SAW ? data->saw_out + offset : NULL;
+    sqr = data->connected & OUT_SQR ? data->sqr_out + offset : NULL;
+    tri = data->connected & OUT_TRI ? data->tri_out + offset : NULL;
+    sine = data->connected & OUT_SIN ? data->sin_out + offset : NULL;
+
+    // the frequency is set once per segment, every frame when it is modulated
+    // at audio rate and every control point when it has a control rate. it is
+    // set even when not modulated, a mod disconnected in the previous call or
+    // a control event would otherwise leave it out of tune
+    for(i = 0; i < nframes; i += n) {
+        n   = clis_param_segment(&params[PARAM_FREQ], freq, i, nframes,
+                &segment);
+        inc = (int32_t)lrintf(clis_segment_ramp(&segment, n, inc_scale));
+
+        tMultiOscSetFreq(data->osc, segment.value);
+
+        if(inc == 0) {
+            tMultiOscTickBlock(data->osc, NULL, frames(saw, i), frames(sqr, i),
+                    frames(tri, i), frames(sine, i), n);
+            continue;
         }
-    } else {
-        // Do this every frame? - do we may have a the last mod disconnected in
-        // the previous process call. That will leave us out of tune.
-        tSawtoothSetFreq(data->saw, f);
-        tSquareSetFreq(data->sqr, f);
-        tTriangleSetFreq(data->tri, f);
-        tCycleSetFreq(data->sin, f);
-
-        for(i = 0; i < nframes; i++) {
-            saw_out[i] = tSawtoothTick(data->saw);
-            sqr_out[i] = tSquareTick(data->sqr);
-            tri_out[i] = tTriangleTick(data->tri);
-            sin_out[i] = tCycleTick(data->sin);
+
+        for(j = i; j < i + n; j++) {
+            tMultiOscTick(data->osc, frames(saw, j), frames(sqr, j),
+                    frames(tri, j), frames(sine, j));
+            data->osc->inc += inc;
         }
     }
 
-    free(mod);
+    if(saw != NULL) scale(saw, amp, 0, nframes);
+    if(sqr != NULL) scale(sqr, amp, 0, nframes);
+    if(tri != NULL) scale(tri, amp, 0, nframes);
+    if(sine != NULL) scale(sine, amp, 0, nframes);
+}
+
+static int
+process(jack_nframes_t nframes, void *arg)
+{
+    process_data *data = (process_data*)arg;
+
+    data->connected = atomic_load(&connected_outputs);
+
+    data->saw_out = (jack_default_audio_sample_t*)jack_port_get_buffer(saw_output_port, nframes);
+    data->sqr_out = (jack_default_audio_sample_t*)jack_port_get_buffer(sqr_output_port, nframes);
+    data->tri_out = (jack_default_audio_sample_t*)jack_port_get_buffer(tri_output_port, nframes);
+    data->sin_out = (jack_default_audio_sample_t*)jack_port_get_buffer(sin_output_port, nframes);
+
+    // control events still apply with nothing connected, render skips it all
+    clis_control_process(&control, nframes, render, data);
 
     return 0;
 }
@@ -125,18 +213,37 @@ int main (int argc, char *argv[])
 {
     char      *client_name = "test";
     char      *server_name = NULL;
+    char      *render_path = NULL;
+    double     render_seconds = 10;
+    char      *control_path = NULL;
+    double     stats_interval = 0;
     int        opt;
+    size_t     i;
     bool       play = false;
+    bool       control_stdin = false;
     clis_rc    rc = CLIS_OK;
 
     atexit(&cleanup);
 
-    while ((opt = getopt(argc, argv, "n:s:f:p")) != -1) {
+    for (i = 0; i < PARAMS_LENGTH; i++) {
+        clis_param_init(&params[i], &param_defs[i]);
+        param_names[i] = param_defs[i].name;
+    }
+
+    while ((opt = getopt(argc, argv, "n:s:f:a:pr:l:cC:S:")) != -1) {
         switch (opt) {
             case 'n': client_name = optarg;                         break;
             case 's': server_name = optarg;                         break;
-            case 'f': rc = clis_parse_param_string(optarg, &freq);  break;
+            case 'f': rc = clis_parse_param_string(optarg, 
+                              &params[PARAM_FREQ]);                 break;
+            case 'a': rc = clis_parse_param_string(optarg, 
+                              &params[PARAM_AMP]);                  break;
             case 'p': play = true;                                  break;
+            case 'r': render_path = optarg;                         break;
+            case 'l': render_seconds = strtod(optarg, NULL);        break;
+            case 'c': control_stdin = true;                         break;
+            case 'C': control_path = optarg;                        break;
+            case 'S': stats_interval = strtod(optarg, NULL);        break;
             default: {
                 fprintf(stderr, "Usage: %s TBC \n", argv[0]);
                 exit(EXIT_FAILURE);
@@ -149,12 +256,10 @@ int main (int argc, char *argv[])
         }
     }
 
-    process_data data = {
-        .saw = tSawtoothInit(),
-        .sqr = tSquareInit(),
-        .tri = tTriangleInit(),
-        .sin = tCycleInit()
-    };
+    // the process thread runs until cleanup closes the client after main
+    // returns, so the oscillators must outlive this frame
+    static process_data data;
+
     rc = clis_init_client(client_name, server_name, &context.client, process, 
                           &data, set_sample_rate, NULL);
     if(rc) {
@@ -165,6 +270,14 @@ int main (int argc, char *argv[])
     srand((unsigned int)time(NULL));
     OOPSInit((float)jack_get_sample_rate(context.client), &frandom);
 
+    // OOPSInit resets the registry and builds the tables, so the oscillator
+    // is taken from it afterwards, as the patch nodes are
+    data.osc = tMultiOscInit();
+    if(data.osc == NULL) {
+        fprintf(stderr, "%s", clis_rc_string(CLIS_E_ALLOC_NODE));
+        exit(EXIT_FAILURE);
+    }
+
     if(register_output_port(context.client, &saw_output_port, "saw") ||
        register_output_port(context.client, &sqr_output_port, "sqr") ||
        register_output_port(context.client, &tri_output_port, "tri") ||
@@ -172,14 +285,77 @@ int main (int argc, char *argv[])
         exit(EXIT_FAILURE);
     }
 
-    clis_start(&context);
+    // reported to JACK for latency compensation, the oscillators render
+    // every frame on time so they add no latency of their own
+    static jack_port_t *outputs[4];
+    outputs[0] = saw_output_port;
+    outputs[1] = sqr_output_port;
+    outputs[2] = tri_output_port;
+    outputs[3] = sin_output_port;
+    context.outputs         = outputs;
+    context.outputs_length  = 4;
+    context.latency         = 0;
+
+    // only the connected outputs are rendered
+    if(jack_set_port_connect_callback(context.client, port_connected,
+                NULL) != 0) {
+        fprintf(stderr, "%s", clis_rc_string(CLIS_E_JACK_CALLBACK));
+        exit(EXIT_FAILURE);
+    }
+
+    rc = clis_start(&context);
+    if(rc) {
+        fprintf(stderr, "%s", clis_rc_string(rc));
+        exit(EXIT_FAILURE);
+    }
+
+    if (control_stdin || control_path) {
+        rc = clis_control_start(&control, context.client, context.params,
+                                param_names, context.params_length,
+                                control_stdin, control_path);
+        if (rc) {
+            fprintf(stderr, "%s\n", clis_rc_string(rc));
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    if (stats_interval > 0) {
+        rc = clis_stats_start(stats_interval);
+        if (rc) {
+            fprintf(stderr, "%s\n", clis_rc_string(rc));
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    // a render captures what is played
+    if (play || render_path) {
+        rc = clis_play_audio(context.client, saw_output_port, sqr_output_port);
+        if (rc) {
+            fprintf(stderr, "%s\n", clis_rc_string(rc));
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    if (render_path) {
+        rc = clis_render(context.client, render_path, render_seconds);
+        if (rc) {
+            fprintf(stderr, "%s: %s\n", render_path, clis_rc_string(rc));
+            exit(EXIT_FAILURE);
+        }
+    } else {
+        clis_run();
+    }
+
+    if (stats_interval > 0) {
+        clis_stats stats;
 
-    if (play) {
-        clis_play_audio(context.client, saw_output_port, sqr_output_port);
-        clis_play_audio(context.client, saw_output_port, sqr_output_port);
+        clis_stats_read(&stats);
+        clis_stats_report(&stats, stdout);
     }
 
-    clis_run();
+#if OOPS_PROFILE
+    OOPSProfileDump(stdout);
+#endif
 
     printf("exiting gracefully\n");
 }
@@ -0,0 +1,1307 @@
+/* A stand-in for libjack that runs its own null server inside the client.
+ *
+ * Linking a program against this instead of libjack gives it a private server
+ * with two silent capture and two discarding playback ports. Periods are timed
+ * by the system clock like the dummy driver of jackd, in freewheel mode they
+ * run back to back as fast as the client can render them. Only one client per
+ * process is supported, which is all the clis tools need.
+ *
+ * The server is configured from the environment:
+ *
+ *   CLIS_NULL_RATE     the sample rate, default 48000
+ *   CLIS_NULL_PERIOD   the period length in frames, default 256
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <regex.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <jack/jack.h>
+#include <jack/midiport.h>
+#include <jack/ringbuffer.h>
+#include <jack/thread.h>
+
+#define NULL_SERVER_NAME    "system"
+#define NULL_MAX_PORTS      1024
+#define NULL_MAX_LINKS      32
+#define NULL_NAME_SIZE      256
+#define NULL_CLIENT_SIZE    64
+#define NULL_CHANNELS       2
+#define DEFAULT_RATE        48000
+#define DEFAULT_PERIOD      256
+#define NULL_MIDI_EVENTS    256     // events per MIDI buffer and period
+#define NULL_MIDI_DATA      2048    // bytes of those events
+
+// the buffer of a MIDI port, the events of a period in time order with their
+// bytes packed in data
+typedef struct null_midi_buffer {
+    uint32_t            length;
+    size_t              used;
+    struct {
+        jack_nframes_t  time;
+        size_t          size;
+        size_t          offset;
+    } events[NULL_MIDI_EVENTS];
+    jack_midi_data_t    data[NULL_MIDI_DATA];
+} null_midi_buffer;
+
+struct _jack_port {
+    jack_port_id_t  id;
+    int             registered;
+    jack_client_t   *owner;         // NULL for the system ports
+    char            name[NULL_NAME_SIZE];
+    const char      *type;
+    unsigned long   flags;
+    jack_default_audio_sample_t *buffer;
+    size_t          links_length;
+    jack_port_t     *links[NULL_MAX_LINKS];
+    jack_latency_range_t latency[2];
+};
+
+struct _jack_client {
+    char                    name[NULL_CLIENT_SIZE];
+    int                     active;
+    pthread_t               driver;
+    pthread_t               notifier;
+    JackProcessCallback     process;
+    void                    *process_arg;
+    JackBufferSizeCallback  bufsize;
+    void                    *bufsize_arg;
+    JackSampleRateCallback  srate;
+    void                    *srate_arg;
+    JackFreewheelCallback   freewheel;
+    void                    *freewheel_arg;
+    JackPortRegistrationCallback registration;
+    void                    *registration_arg;
+    JackPortConnectCallback connect;
+    void                    *connect_arg;
+    JackLatencyCallback     latency;
+    void                    *latency_arg;
+    JackXRunCallback        xrun;
+    void                    *xrun_arg;
+    JackShutdownCallback    shutdown;
+    void                    *shutdown_arg;
+};
+
+// graph changes queued for the notification thread
+typedef struct notification {
+    enum {
+        NOTIFY_REGISTER, NOTIFY_CONNECT, NOTIFY_FREEWHEEL, NOTIFY_LATENCY,
+        NOTIFY_XRUN
+    } type;
+    jack_port_id_t          a;
+    jack_port_id_t          b;
+    int                     on;
+    struct notification     *next;
+} notification;
+
+static struct {
+    pthread_mutex_t     graph_lock;     // held by the driver for each period
+    jack_client_t       *client;
+    jack_nframes_t      rate;
+    jack_nframes_t      period;
+    jack_port_t         ports[NULL_MAX_PORTS];
+    size_t              ports_length;
+    atomic_int          freewheel;
+    atomic_int          stop_driver;
+    int                 stop_notifier;  // guarded by notify_lock
+    // frame time of the start of the current period and when it started
+    atomic_uint         frame;
+    _Atomic jack_time_t frame_usecs;
+    pthread_mutex_t     notify_lock;
+    pthread_cond_t      notify_cond;
+    notification        *notify_head;
+    notification        **notify_tail;
+} server = {
+    .graph_lock     = PTHREAD_MUTEX_INITIALIZER,
+    .notify_lock    = PTHREAD_MUTEX_INITIALIZER,
+    .notify_cond    = PTHREAD_COND_INITIALIZER,
+};
+
+static jack_nframes_t
+env_frames(const char *name, jack_nframes_t fallback)
+{
+    const char *value = getenv(name);
+    long frames = value ? strtol(value, NULL, 10) : 0;
+
+    return frames > 0 ? (jack_nframes_t)frames : fallback;
+}
+
+static size_t
+buffer_size(void)
+{
+    size_t audio = server.period * sizeof(jack_default_audio_sample_t);
+
+    return audio > sizeof(null_midi_buffer) ? audio : sizeof(null_midi_buffer);
+}
+
+static jack_port_t *
+add_port(jack_client_t *owner, const char *name, const char *type,
+         unsigned long flags)
+{
+    jack_port_t *port = NULL;
+    size_t i;
+
+    for(i = 0; i < server.ports_length; i++) {
+        if(!server.ports[i].registered) {
+            port = &server.ports[i];
+            break;
+        }
+    }
+    if(port == NULL) {
+        if(server.ports_length == NULL_MAX_PORTS)
+            return NULL;
+        port = &server.ports[server.ports_length];
+        port->id = (jack_port_id_t)server.ports_length++;
+    }
+
+    // big enough for either type, a port slot may be reused for the other
+    if(port->buffer == NULL)
+        port->buffer = calloc(1, buffer_size());
+    if(port->buffer == NULL)
+        return NULL;
+
+    memset(port->buffer, 0, buffer_size());
+    snprintf(port->name, sizeof port->name, "%s:%s",
+            owner ? owner->name : NULL_SERVER_NAME, name);
+    port->owner         = owner;
+    port->type          = type;
+    port->flags         = flags;
+    port->links_length  = 0;
+    memset(port->latency, 0, sizeof port->latency);
+    port->registered    = 1;
+
+    return port;
+}
+
+static void
+start_server(void)
+{
+    jack_port_t *port;
+    char name[16];
+    int i;
+
+    server.rate         = env_frames("CLIS_NULL_RATE", DEFAULT_RATE);
+    server.period       = env_frames("CLIS_NULL_PERIOD", DEFAULT_PERIOD);
+    server.ports_length = 0;
+    server.notify_head  = NULL;
+    server.notify_tail  = &server.notify_head;
+    atomic_store(&server.freewheel, 0);
+    atomic_store(&server.stop_driver, 0);
+    server.stop_notifier = 0;
+    atomic_store(&server.frame, 0);
+    atomic_store(&server.frame_usecs, jack_get_time());
+
+    // the hardware is a period behind on capture and ahead on playback
+    for(i = 1; i <= NULL_CHANNELS; i++) {
+        snprintf(name, sizeof name, "capture_%d", i);
+        port = add_port(NULL, name, JACK_DEFAULT_AUDIO_TYPE,
+                JackPortIsOutput | JackPortIsPhysical | JackPortIsTerminal);
+        port->latency[JackCaptureLatency].min = server.period;
+        port->latency[JackCaptureLatency].max = server.period;
+        snprintf(name, sizeof name, "playback_%d", i);
+        port = add_port(NULL, name, JACK_DEFAULT_AUDIO_TYPE,
+                JackPortIsInput | JackPortIsPhysical | JackPortIsTerminal);
+        port->latency[JackPlaybackLatency].min = server.period;
+        port->latency[JackPlaybackLatency].max = server.period;
+    }
+}
+
+static jack_port_t *
+find_port(const char *name)
+{
+    size_t i;
+
+    for(i = 0; i < server.ports_length; i++) {
+        if(server.ports[i].registered && strcmp(server.ports[i].name, name) == 0)
+            return &server.ports[i];
+    }
+
+    return NULL;
+}
+
+/* notifications */
+
+static void
+notify(int type, jack_port_id_t a, jack_port_id_t b, int on)
+{
+    notification *n = malloc(sizeof *n);
+
+    if(n == NULL)
+        return;
+
+    n->type = type;
+    n->a    = a;
+    n->b    = b;
+    n->on   = on;
+    n->next = NULL;
+
+    pthread_mutex_lock(&server.notify_lock);
+    *server.notify_tail = n;
+    server.notify_tail  = &n->next;
+    pthread_cond_signal(&server.notify_cond);
+    pthread_mutex_unlock(&server.notify_lock);
+}
+
+// calls the clients graph callbacks from a thread of their own, like jackd
+static void *
+notifier_main(void *arg)
+{
+    jack_client_t *client = (jack_client_t *)arg;
+    notification *n;
+
+    for(;;) {
+        pthread_mutex_lock(&server.notify_lock);
+        while(server.notify_head == NULL && !server.stop_notifier)
+            pthread_cond_wait(&server.notify_cond, &server.notify_lock);
+
+        n = server.notify_head;
+        if(n == NULL) {
+            pthread_mutex_unlock(&server.notify_lock);
+            return NULL;
+        }
+        server.notify_head = n->next;
+        if(server.notify_head == NULL)
+            server.notify_tail = &server.notify_head;
+        pthread_mutex_unlock(&server.notify_lock);
+
+        switch(n->type) {
+            case NOTIFY_REGISTER:
+                if(client->registration)
+                    client->registration(n->a, n->on, client->registration_arg);
+                break;
+            case NOTIFY_CONNECT:
+                if(client->connect)
+                    client->connect(n->a, n->b, n->on, client->connect_arg);
+                break;
+            case NOTIFY_FREEWHEEL:
+                if(client->freewheel)
+                    client->freewheel(n->on, client->freewheel_arg);
+                break;
+            case NOTIFY_LATENCY:
+                if(client->latency) {
+                    client->latency(JackCaptureLatency, client->latency_arg);
+                    client->latency(JackPlaybackLatency, client->latency_arg);
+                }
+                break;
+            case NOTIFY_XRUN:
+                if(client->xrun)
+                    client->xrun(client->xrun_arg);
+                break;
+        }
+
+        free(n);
+    }
+}
+
+/* driver */
+
+static void
+timespec_add_ns(struct timespec *ts, long ns)
+{
+    ts->tv_nsec += ns;
+    while(ts->tv_nsec >= 1000000000) {
+        ts->tv_nsec -= 1000000000;
+        ts->tv_sec++;
+    }
+}
+
+static void *
+driver_main(void *arg)
+{
+    jack_client_t *client = (jack_client_t *)arg;
+    long period_ns = (long)((double)server.period * 1e9 / server.rate);
+    struct timespec next, late, now;
+    jack_nframes_t frame = 0;
+    int freewheel;
+
+    clock_gettime(CLOCK_MONOTONIC, &next);
+
+    while(!atomic_load(&server.stop_driver)) {
+        freewheel = atomic_load(&server.freewheel);
+
+        if(freewheel) {
+            clock_gettime(CLOCK_MONOTONIC, &next);
+        } else {
+            timespec_add_ns(&next, period_ns);
+            while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL)
+                    == EINTR)
+                ;
+        }
+
+        pthread_mutex_lock(&server.graph_lock);
+        atomic_store(&server.frame, frame);
+        atomic_store(&server.frame_usecs, jack_get_time());
+        if(client->process)
+            client->process(server.period, client->process_arg);
+        frame += server.period;
+        pthread_mutex_unlock(&server.graph_lock);
+
+        // a period that ran past the start of the next one is an xrun, the
+        // periods missed are skipped rather than run late to catch up
+        if(!freewheel) {
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            late = next;
+            timespec_add_ns(&late, period_ns);
+            if(now.tv_sec > late.tv_sec ||
+                    (now.tv_sec == late.tv_sec && now.tv_nsec > late.tv_nsec)) {
+                notify(NOTIFY_XRUN, 0, 0, 1);
+                next = now;
+            }
+        }
+
+        // let the clients main thread in between back to back periods
+        if(freewheel)
+            sched_yield();
+    }
+
+    return NULL;
+}
+
+// server threads leave signals to the clients main thread
+static int
+create_thread(pthread_t *thread, void *(*start)(void *), void *arg)
+{
+    sigset_t all, old;
+    int rc;
+
+    sigfillset(&all);
+    pthread_sigmask(SIG_SETMASK, &all, &old);
+    rc = pthread_create(thread, NULL, start, arg);
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+
+    return rc;
+}
+
+/* clients */
+
+jack_client_t *
+jack_client_open(const char *client_name, jack_options_t options,
+                 jack_status_t *status, ...)
+{
+    jack_client_t *client;
+    jack_status_t dummy;
+
+    (void)options;
+
+    if(status == NULL)
+        status = &dummy;
+    *status = 0;
+
+    if(server.client != NULL) {
+        *status = JackFailure | JackServerError;
+        return NULL;
+    }
+
+    client = calloc(1, sizeof *client);
+    if(client == NULL) {
+        *status = JackFailure;
+        return NULL;
+    }
+
+    snprintf(client->name, sizeof client->name, "%s", client_name);
+    if(strcmp(client->name, NULL_SERVER_NAME) == 0) {
+        free(client);
+        *status = JackFailure | JackNameNotUnique;
+        return NULL;
+    }
+
+    start_server();
+    server.client = client;
+
+    if(create_thread(&client->notifier, notifier_main, client) != 0) {
+        server.client = NULL;
+        free(client);
+        *status = JackFailure | JackServerFailed;
+        return NULL;
+    }
+
+    return client;
+}
+
+int
+jack_activate(jack_client_t *client)
+{
+    if(client->active)
+        return 0;
+
+    if(client->bufsize)
+        client->bufsize(server.period, client->bufsize_arg);
+
+    if(create_thread(&client->driver, driver_main, client) != 0)
+        return -1;
+
+    client->active = 1;
+    notify(NOTIFY_LATENCY, 0, 0, 1);
+
+    return 0;
+}
+
+int
+jack_deactivate(jack_client_t *client)
+{
+    if(!client->active)
+        return 0;
+
+    atomic_store(&server.stop_driver, 1);
+    pthread_join(client->driver, NULL);
+    atomic_store(&server.stop_driver, 0);
+    client->active = 0;
+
+    return 0;
+}
+
+int
+jack_client_close(jack_client_t *client)
+{
+    size_t i;
+
+    jack_deactivate(client);
+
+    pthread_mutex_lock(&server.notify_lock);
+    server.stop_notifier = 1;
+    pthread_cond_signal(&server.notify_cond);
+    pthread_mutex_unlock(&server.notify_lock);
+    pthread_join(client->notifier, NULL);
+
+    while(server.notify_head != NULL) {
+        notification *n = server.notify_head;
+
+        server.notify_head = n->next;
+        free(n);
+    }
+
+    for(i = 0; i < server.ports_length; i++) {
+        free(server.ports[i].buffer);
+        memset(&server.ports[i], 0, sizeof server.ports[i]);
+    }
+    server.ports_length = 0;
+    server.client       = NULL;
+    free(client);
+
+    return 0;
+}
+
+int
+jack_client_name_size(void)
+{
+    return NULL_CLIENT_SIZE;
+}
+
+char *
+jack_get_client_name(jack_client_t *client)
+{
+    return client->name;
+}
+
+int
+jack_is_realtime(jack_client_t *client)
+{
+    (void)client;
+
+    return 0;
+}
+
+jack_nframes_t
+jack_get_sample_rate(jack_client_t *client)
+{
+    (void)client;
+
+    return server.rate;
+}
+
+jack_nframes_t
+jack_get_buffer_size(jack_client_t *client)
+{
+    (void)client;
+
+    return server.period;
+}
+
+float
+jack_cpu_load(jack_client_t *client)
+{
+    (void)client;
+
+    return 0.0f;
+}
+
+int
+jack_set_freewheel(jack_client_t *client, int onoff)
+{
+    (void)client;
+
+    if(atomic_exchange(&server.freewheel, onoff != 0) != (onoff != 0))
+        notify(NOTIFY_FREEWHEEL, 0, 0, onoff != 0);
+
+    return 0;
+}
+
+/* callbacks */
+
+void
+jack_on_shutdown(jack_client_t *client, JackShutdownCallback callback,
+                 void *arg)
+{
+    client->shutdown        = callback;
+    client->shutdown_arg    = arg;
+}
+
+int
+jack_set_process_callback(jack_client_t *client, JackProcessCallback callback,
+                          void *arg)
+{
+    if(client->active)
+        return -1;
+
+    client->process     = callback;
+    client->process_arg = arg;
+
+    return 0;
+}
+
+int
+jack_set_buffer_size_callback(jack_client_t *client,
+                              JackBufferSizeCallback callback, void *arg)
+{
+    client->bufsize     = callback;
+    client->bufsize_arg = arg;
+
+    return 0;
+}
+
+int
+jack_set_sample_rate_callback(jack_client_t *client,
+                              JackSampleRateCallback callback, void *arg)
+{
+    client->srate       = callback;
+    client->srate_arg   = arg;
+
+    return 0;
+}
+
+int
+jack_set_freewheel_callback(jack_client_t *client,
+                            JackFreewheelCallback callback, void *arg)
+{
+    client->freewheel       = callback;
+    client->freewheel_arg   = arg;
+
+    return 0;
+}
+
+int
+jack_set_port_registration_callback(jack_client_t *client,
+                                    JackPortRegistrationCallback callback,
+                                    void *arg)
+{
+    client->registration        = callback;
+    client->registration_arg    = arg;
+
+    return 0;
+}
+
+int
+jack_set_port_connect_callback(jack_client_t *client,
+                               JackPortConnectCallback callback, void *arg)
+{
+    client->connect     = callback;
+    client->connect_arg = arg;
+
+    return 0;
+}
+
+int
+jack_set_latency_callback(jack_client_t *client,
+                          JackLatencyCallback callback, void *arg)
+{
+    client->latency     = callback;
+    client->latency_arg = arg;
+
+    return 0;
+}
+
+int
+jack_set_xrun_callback(jack_client_t *client, JackXRunCallback callback,
+                       void *arg)
+{
+    client->xrun        = callback;
+    client->xrun_arg    = arg;
+
+    return 0;
+}
+
+int
+jack_recompute_total_latencies(jack_client_t *client)
+{
+    (void)client;
+
+    notify(NOTIFY_LATENCY, 0, 0, 1);
+
+    return 0;
+}
+
+/* ports */
+
+jack_port_t *
+jack_port_register(jack_client_t *client, const char *port_name,
+                   const char *port_type, unsigned long flags,
+                   unsigned long buffer_size)
+{
+    char name[NULL_NAME_SIZE];
+    jack_port_t *port;
+
+    (void)buffer_size;
+
+    if(strcmp(port_type, JACK_DEFAULT_AUDIO_TYPE) == 0)
+        port_type = JACK_DEFAULT_AUDIO_TYPE;
+    else if(strcmp(port_type, JACK_DEFAULT_MIDI_TYPE) == 0)
+        port_type = JACK_DEFAULT_MIDI_TYPE;
+    else
+        return NULL;
+
+    if(snprintf(name, sizeof name, "%s:%s", client->name, port_name)
+            >= (int)sizeof name)
+        return NULL;
+
+    pthread_mutex_lock(&server.graph_lock);
+    port = find_port(name) == NULL
+        ? add_port(client, port_name, port_type, flags)
+        : NULL;
+    pthread_mutex_unlock(&server.graph_lock);
+
+    if(port)
+        notify(NOTIFY_REGISTER, port->id, 0, 1);
+
+    return port;
+}
+
+static int
+unlink_ports(jack_port_t *src, jack_port_t *dst)
+{
+    size_t i;
+
+    for(i = 0; i < dst->links_length; i++) {
+        if(dst->links[i] == src)
+            break;
+    }
+    if(i == dst->links_length)
+        return -1;
+
+    dst->links[i] = dst->links[--dst->links_length];
+
+    for(i = 0; i < src->links_length; i++) {
+        if(src->links[i] == dst) {
+            src->links[i] = src->links[--src->links_length];
+            break;
+        }
+    }
+
+    return 0;
+}
+
+int
+jack_port_unregister(jack_client_t *client, jack_port_t *port)
+{
+    jack_port_id_t id = port->id;
+
+    if(port->owner != client)
+        return -1;
+
+    pthread_mutex_lock(&server.graph_lock);
+    while(port->links_length > 0) {
+        jack_port_t *other = port->links[0];
+
+        if(port->flags & JackPortIsOutput)
+            unlink_ports(port, other);
+        else
+            unlink_ports(other, port);
+        notify(NOTIFY_CONNECT, port->id, other->id, 0);
+        notify(NOTIFY_LATENCY, 0, 0, 1);
+    }
+    port->registered = 0;
+    pthread_mutex_unlock(&server.graph_lock);
+
+    notify(NOTIFY_REGISTER, id, 0, 0);
+
+    return 0;
+}
+
+/**
+ * Merge the events of every source of a MIDI input in time order.
+ */
+static void
+merge_midi(jack_port_t *port)
+{
+    null_midi_buffer *out = (null_midi_buffer *)port->buffer;
+    null_midi_buffer *in;
+    uint32_t next[NULL_MAX_LINKS] = { 0 };
+    jack_midi_event_t event;
+    size_t i, first;
+
+    jack_midi_clear_buffer(out);
+
+    for(;;) {
+        first = port->links_length;
+        for(i = 0; i < port->links_length; i++) {
+            in = (null_midi_buffer *)port->links[i]->buffer;
+            if(next[i] < in->length && (first == port->links_length ||
+                    in->events[next[i]].time < ((null_midi_buffer *)
+                        port->links[first]->buffer)->events[next[first]].time))
+                first = i;
+        }
+        if(first == port->links_length)
+            return;
+
+        if(jack_midi_event_get(&event, port->links[first]->buffer,
+                    next[first]++) == 0)
+            jack_midi_event_write(out, event.time, event.buffer, event.size);
+    }
+}
+
+/**
+ * Output ports own their buffer. Input ports see the buffer of their only
+ * source directly or a mix of all of them, unconnected inputs are silent.
+ * Called from the process thread while the driver holds the graph lock.
+ */
+void *
+jack_port_get_buffer(jack_port_t *port, jack_nframes_t nframes)
+{
+    size_t i;
+    jack_nframes_t j;
+
+    if(port->flags & JackPortIsOutput)
+        return port->buffer;
+
+    if(port->links_length == 1)
+        return port->links[0]->buffer;
+
+    if(strcmp(port->type, JACK_DEFAULT_MIDI_TYPE) == 0) {
+        merge_midi(port);
+        return port->buffer;
+    }
+
+    memset(port->buffer, 0, nframes * sizeof *port->buffer);
+    for(i = 0; i < port->links_length; i++) {
+        for(j = 0; j < nframes; j++) {
+            port->buffer[j] += port->links[i]->buffer[j];
+        }
+    }
+
+    return port->buffer;
+}
+
+const char *
+jack_port_name(const jack_port_t *port)
+{
+    return port->name;
+}
+
+const char *
+jack_port_short_name(const jack_port_t *port)
+{
+    return strchr(port->name, ':') + 1;
+}
+
+int
+jack_port_flags(const jack_port_t *port)
+{
+    return (int)port->flags;
+}
+
+const char *
+jack_port_type(const jack_port_t *port)
+{
+    return port->type;
+}
+
+/**
+ * Like jackd, the range of a port towards the rest of the graph, the capture
+ * latency of an input or the playback latency of an output, is that of the
+ * ports connected to it. The range of the other direction is whatever its
+ * owner set.
+ */
+void
+jack_port_get_latency_range(jack_port_t *port,
+                            jack_latency_callback_mode_t mode,
+                            jack_latency_range_t *range)
+{
+    int upstream = mode == JackCaptureLatency
+        ? (port->flags & JackPortIsInput) != 0
+        : (port->flags & JackPortIsOutput) != 0;
+    size_t i;
+
+    pthread_mutex_lock(&server.graph_lock);
+    if(!upstream) {
+        *range = port->latency[mode];
+    } else if(port->links_length == 0) {
+        range->min = 0;
+        range->max = 0;
+    } else {
+        *range = port->links[0]->latency[mode];
+        for(i = 1; i < port->links_length; i++) {
+            if(port->links[i]->latency[mode].min < range->min)
+                range->min = port->links[i]->latency[mode].min;
+            if(port->links[i]->latency[mode].max > range->max)
+                range->max = port->links[i]->latency[mode].max;
+        }
+    }
+    pthread_mutex_unlock(&server.graph_lock);
+}
+
+void
+jack_port_set_latency_range(jack_port_t *port,
+                            jack_latency_callback_mode_t mode,
+                            jack_latency_range_t *range)
+{
+    pthread_mutex_lock(&server.graph_lock);
+    port->latency[mode] = *range;
+    pthread_mutex_unlock(&server.graph_lock);
+}
+
+int
+jack_port_is_mine(const jack_client_t *client, const jack_port_t *port)
+{
+    return port->owner == client;
+}
+
+int
+jack_port_connected(const jack_port_t *port)
+{
+    return (int)port->links_length;
+}
+
+int
+jack_port_connected_to(const jack_port_t *port, const char *port_name)
+{
+    size_t i;
+
+    for(i = 0; i < port->links_length; i++) {
+        if(strcmp(port->links[i]->name, port_name) == 0)
+            return 1;
+    }
+
+    return 0;
+}
+
+const char **
+jack_port_get_connections(const jack_port_t *port)
+{
+    const char **names;
+    size_t i;
+
+    if(port->links_length == 0)
+        return NULL;
+
+    names = calloc(port->links_length + 1, sizeof *names);
+    if(names == NULL)
+        return NULL;
+
+    for(i = 0; i < port->links_length; i++) {
+        names[i] = port->links[i]->name;
+    }
+
+    return names;
+}
+
+int
+jack_port_name_size(void)
+{
+    return NULL_NAME_SIZE;
+}
+
+jack_port_t *
+jack_port_by_name(jack_client_t *client, const char *port_name)
+{
+    jack_port_t *port;
+
+    (void)client;
+
+    pthread_mutex_lock(&server.graph_lock);
+    port = find_port(port_name);
+    pthread_mutex_unlock(&server.graph_lock);
+
+    return port;
+}
+
+jack_port_t *
+jack_port_by_id(jack_client_t *client, jack_port_id_t port_id)
+{
+    (void)client;
+
+    if(port_id >= server.ports_length)
+        return NULL;
+
+    return &server.ports[port_id];
+}
+
+const char **
+jack_get_ports(jack_client_t *client, const char *port_name_pattern,
+               const char *type_name_pattern, unsigned long flags)
+{
+    regex_t name_re, type_re;
+    const char **names;
+    size_t i, length = 0;
+    int by_name = port_name_pattern && port_name_pattern[0];
+    int by_type = type_name_pattern && type_name_pattern[0];
+
+    (void)client;
+
+    if(by_name && regcomp(&name_re, port_name_pattern,
+                REG_EXTENDED | REG_NOSUB) != 0)
+        return NULL;
+    if(by_type && regcomp(&type_re, type_name_pattern,
+                REG_EXTENDED | REG_NOSUB) != 0) {
+        if(by_name)
+            regfree(&name_re);
+        return NULL;
+    }
+
+    pthread_mutex_lock(&server.graph_lock);
+    names = calloc(server.ports_length + 1, sizeof *names);
+    for(i = 0; names && i < server.ports_length; i++) {
+        jack_port_t *port = &server.ports[i];
+
+        if(!port->registered || (port->flags & flags) != flags)
+            continue;
+        if(by_name && regexec(&name_re, port->name, 0, NULL, 0) != 0)
+            continue;
+        if(by_type && regexec(&type_re, port->type, 0, NULL, 0) != 0)
+            continue;
+
+        names[length++] = port->name;
+    }
+    pthread_mutex_unlock(&server.graph_lock);
+
+    if(by_name)
+        regfree(&name_re);
+    if(by_type)
+        regfree(&type_re);
+
+    if(names && length == 0) {
+        free(names);
+        names = NULL;
+    }
+
+    return names;
+}
+
+int
+jack_connect(jack_client_t *client, const char *source_port,
+             const char *destination_port)
+{
+    jack_port_t *src, *dst;
+    int rc = 0;
+
+    (void)client;
+
+    pthread_mutex_lock(&server.graph_lock);
+    src = find_port(source_port);
+    dst = find_port(destination_port);
+
+    if(!src || !dst || !(src->flags & JackPortIsOutput) ||
+            !(dst->flags & JackPortIsInput) || strcmp(src->type, dst->type) != 0)
+        rc = -1;
+    else if(jack_port_connected_to(src, destination_port))
+        rc = EEXIST;
+    else if(src->links_length == NULL_MAX_LINKS ||
+            dst->links_length == NULL_MAX_LINKS)
+        rc = -1;
+    else {
+        src->links[src->links_length++] = dst;
+        dst->links[dst->links_length++] = src;
+    }
+    pthread_mutex_unlock(&server.graph_lock);
+
+    if(rc == 0) {
+        notify(NOTIFY_CONNECT, src->id, dst->id, 1);
+        notify(NOTIFY_LATENCY, 0, 0, 1);
+    }
+
+    return rc;
+}
+
+int
+jack_disconnect(jack_client_t *client, const char *source_port,
+                const char *destination_port)
+{
+    jack_port_t *src, *dst;
+    int rc = -1;
+
+    (void)client;
+
+    pthread_mutex_lock(&server.graph_lock);
+    src = find_port(source_port);
+    dst = find_port(destination_port);
+    if(src && dst)
+        rc = unlink_ports(src, dst);
+    pthread_mutex_unlock(&server.graph_lock);
+
+    if(rc == 0) {
+        notify(NOTIFY_CONNECT, src->id, dst->id, 0);
+        notify(NOTIFY_LATENCY, 0, 0, 1);
+    }
+
+    return rc;
+}
+
+/* midi */
+
+uint32_t
+jack_midi_get_event_count(void *port_buffer)
+{
+    return ((null_midi_buffer *)port_buffer)->length;
+}
+
+int
+jack_midi_event_get(jack_midi_event_t *event, void *port_buffer,
+                    uint32_t event_index)
+{
+    null_midi_buffer *midi = (null_midi_buffer *)port_buffer;
+
+    if(event_index >= midi->length)
+        return -ENODATA;
+
+    event->time     = midi->events[event_index].time;
+    event->size     = midi->events[event_index].size;
+    event->buffer   = midi->data + midi->events[event_index].offset;
+
+    return 0;
+}
+
+void
+jack_midi_clear_buffer(void *port_buffer)
+{
+    null_midi_buffer *midi = (null_midi_buffer *)port_buffer;
+
+    midi->length    = 0;
+    midi->used      = 0;
+}
+
+/**
+ * Like jackd, events must be written in time order within the period.
+ */
+int
+jack_midi_event_write(void *port_buffer, jack_nframes_t time,
+                      const jack_midi_data_t *data, size_t data_size)
+{
+    null_midi_buffer *midi = (null_midi_buffer *)port_buffer;
+
+    if(time >= server.period || (midi->length > 0 &&
+                time < midi->events[midi->length - 1].time))
+        return -EINVAL;
+    if(midi->length == NULL_MIDI_EVENTS ||
+            data_size > NULL_MIDI_DATA - midi->used)
+        return -ENOBUFS;
+
+    midi->events[midi->length].time     = time;
+    midi->events[midi->length].size     = data_size;
+    midi->events[midi->length].offset   = midi->used;
+    memcpy(midi->data + midi->used, data, data_size);
+    midi->used += data_size;
+    midi->length++;
+
+    return 0;
+}
+
+/* time */
+
+jack_time_t
+jack_get_time(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (jack_time_t)ts.tv_sec * 1000000 + (jack_time_t)ts.tv_nsec / 1000;
+}
+
+jack_nframes_t
+jack_last_frame_time(const jack_client_t *client)
+{
+    (void)client;
+
+    return atomic_load(&server.frame);
+}
+
+jack_nframes_t
+jack_frames_since_cycle_start(const jack_client_t *client)
+{
+    jack_time_t elapsed = jack_get_time() - atomic_load(&server.frame_usecs);
+    jack_nframes_t frames = (jack_nframes_t)(elapsed * server.rate / 1000000);
+
+    (void)client;
+
+    // freewheeling periods take as long as they take, never report more
+    // frames than a period has
+    return frames < server.period ? frames : server.period - 1;
+}
+
+jack_nframes_t
+jack_frame_time(const jack_client_t *client)
+{
+    return jack_last_frame_time(client) + jack_frames_since_cycle_start(client);
+}
+
+/* threads */
+
+int
+jack_client_real_time_priority(jack_client_t *client)
+{
+    (void)client;
+
+    return -1;
+}
+
+int
+jack_client_create_thread(jack_client_t *client, jack_native_thread_t *thread,
+                          int priority, int realtime,
+                          void *(*start_routine)(void *), void *arg)
+{
+    (void)client;
+    (void)priority;
+    (void)realtime;
+
+    return create_thread(thread, start_routine, arg);
+}
+
+/* memory */
+
+void
+jack_free(void *ptr)
+{
+    free(ptr);
+}
+
+/* ring buffers, single reader and single writer like the JACK ones */
+
+jack_ringbuffer_t *
+jack_ringbuffer_create(size_t sz)
+{
+    jack_ringbuffer_t *rb = calloc(1, sizeof *rb);
+    size_t size = 1;
+
+    if(rb == NULL)
+        return NULL;
+
+    while(size < sz + 1)
+        size <<= 1;
+
+    rb->buf = malloc(size);
+    if(rb->buf == NULL) {
+        free(rb);
+        return NULL;
+    }
+    rb->size        = size;
+    rb->size_mask   = size - 1;
+
+    return rb;
+}
+
+void
+jack_ringbuffer_free(jack_ringbuffer_t *rb)
+{
+    // like libjack, there is no check for NULL
+    free(rb->buf);
+    free(rb);
+}
+
+int
+jack_ringbuffer_mlock(jack_ringbuffer_t *rb)
+{
+    rb->mlocked = 1;
+
+    return 0;
+}
+
+void
+jack_ringbuffer_reset(jack_ringbuffer_t *rb)
+{
+    rb->read_ptr    = 0;
+    rb->write_ptr   = 0;
+}
+
+size_t
+jack_ringbuffer_read_space(const jack_ringbuffer_t *rb)
+{
+    size_t w = __atomic_load_n(&rb->write_ptr, __ATOMIC_ACQUIRE);
+    size_t r = __atomic_load_n(&rb->read_ptr, __ATOMIC_RELAXED);
+
+    return (w - r) & rb->size_mask;
+}
+
+size_t
+jack_ringbuffer_write_space(const jack_ringbuffer_t *rb)
+{
+    size_t w = __atomic_load_n(&rb->write_ptr, __ATOMIC_RELAXED);
+    size_t r = __atomic_load_n(&rb->read_ptr, __ATOMIC_ACQUIRE);
+
+    return (r - w - 1) & rb->size_mask;
+}
+
+static void
+copy_out(const jack_ringbuffer_t *rb, char *dest, size_t cnt)
+{
+    size_t r        = rb->read_ptr & rb->size_mask;
+    size_t first    = rb->size - r < cnt ? rb->size - r : cnt;
+
+    memcpy(dest, rb->buf + r, first);
+    memcpy(dest + first, rb->buf, cnt - first);
+}
+
+size_t
+jack_ringbuffer_peek(jack_ringbuffer_t *rb, char *dest, size_t cnt)
+{
+    size_t space = jack_ringbuffer_read_space(rb);
+
+    if(cnt > space)
+        cnt = space;
+
+    copy_out(rb, dest, cnt);
+
+    return cnt;
+}
+
+void
+jack_ringbuffer_read_advance(jack_ringbuffer_t *rb, size_t cnt)
+{
+    __atomic_store_n(&rb->read_ptr, (rb->read_ptr + cnt) & rb->size_mask,
+            __ATOMIC_RELEASE);
+}
+
+size_t
+jack_ringbuffer_read(jack_ringbuffer_t *rb, char *dest, size_t cnt)
+{
+    cnt = jack_ringbuffer_peek(rb, dest, cnt);
+    jack_ringbuffer_read_advance(rb, cnt);
+
+    return cnt;
+}
+
+size_t
+jack_ringbuffer_write(jack_ringbuffer_t *rb, const char *src, size_t cnt)
+{
+    size_t space = jack_ringbuffer_write_space(rb);
+    size_t w, first;
+
+    if(cnt > space)
+        cnt = space;
+
+    w       = rb->write_ptr & rb->size_mask;
+    first   = rb->size - w < cnt ? rb->size - w : cnt;
+
+    memcpy(rb->buf + w, src, first);
+    memcpy(rb->buf, src + first, cnt - first);
+
+    __atomic_store_n(&rb->write_ptr, (rb->write_ptr + cnt) & rb->size_mask,
+            __ATOMIC_RELEASE);
+
+    return cnt;
+}
@@ -0,0 +1,11 @@
+#!/usr/bin/env bash
+
+# the same patch as test--mods.sh in a single JACK client
+./clis-host -n host \
+    'lfo lfo1 -f 0.5' \
+    'lfo lfo2 -f 1' \
+    'osc osc -f 40 -f lfo1:sqr:0.0001 -f lfo2:sqr:0.0001 -p' &
+
+read -n 1 -s -r -p "Press any key to continue\n"
+
+pkill -2 -P $$
@@ -0,0 +1,7 @@
+#!/usr/bin/env bash
+
+# render the test--mods.sh patch without a JACK server
+./clis-host-null -t -r test-render.wav -l 10 \
+    'lfo lfo1 -f 0.5' \
+    'lfo lfo2 -f 1' \
+    'osc osc -f 40 -f lfo1:sqr:0.0001 -f lfo2:sqr:0.0001 -p'